@@ -20,8 +20,9 @@
 #include <stdexcept>
 #include <map>
 #include <algorithm>
+#include <tuple>
 
-#include <regex>
+#include <cctype>
 
 #include <ostream> //probs not needed later
 #include <iostream>
@@ -35,14 +36,45 @@
   Construct an Area with a given local authority code.
 
   @param localAuthorityCode
-    The local authority code of the Area
+    The local authority code of the Area, which is interned if it is not
+    already a Symbol
+
+  @param alloc
+    The allocator for the Area's names and measures, which is the default
+    memory resource unless the Area is being created inside a std::pmr
+    container such as an Areas instance's AreasContainer
 
   @example
     Area("W06000023");
 */
-Area::Area(const std::string& localAuthorityCode) {
-  this->localAuthorityCode = localAuthorityCode;
-}
+Area::Area(Symbol localAuthorityCode, const allocator_type& alloc)
+    : localAuthorityCode(localAuthorityCode), namesMap(alloc), measures(alloc) {}
+
+Area::Area(const std::string& localAuthorityCode, const allocator_type& alloc)
+    : Area(Symbol(localAuthorityCode), alloc) {}
+
+/*
+  Area::Area(other, alloc)
+
+  Copy or move an Area into storage from another allocator, as a std::pmr
+  container does when an Area is inserted into it. Its Measures are copied or
+  moved into the same storage.
+
+  @param other
+    The Area to copy or move
+
+  @param alloc
+    The allocator for the new Area's names and measures
+*/
+Area::Area(const Area& other, const allocator_type& alloc)
+    : localAuthorityCode(other.localAuthorityCode),
+      namesMap(other.namesMap, alloc),
+      measures(other.measures, alloc) {}
+
+Area::Area(Area&& other, const allocator_type& alloc)
+    : localAuthorityCode(other.localAuthorityCode),
+      namesMap(std::move(other.namesMap), alloc),
+      measures(std::move(other.measures), alloc) {}
 
 /*
   TODO: Area::getLocalAuthorityCode()
@@ -58,7 +90,7 @@ Area::Area(const std::string& localAuthorityCode) {
     ...
     auto authCode = area.getLocalAuthorityCode();
 */
-std::string Area::getLocalAuthorityCode(){
+const std::string& Area::getLocalAuthorityCode() const noexcept{
   return this->localAuthorityCode;
 }
 
@@ -86,9 +118,10 @@ std::string Area::getLocalAuthorityCode(){
     ...
     auto name = area.getName(langCode);
 */
-std::string Area::getName(std::string langCode){
-  if(namesMap.count(langCode) > 0){
-    return namesMap.find(langCode)->second;
+std::string Area::getName(std::string langCode) const{
+  auto it = namesMap.find(std::string_view(langCode));
+  if(it != namesMap.end()){
+    return std::string(it->second);
   }else{
     throw std::out_of_range("getName area FIND CORRECT ERROR MESSAGE"+ langCode);
   }
@@ -123,11 +156,14 @@ void Area::setName(std::string lang, std::string name){
   int len = lang.length();
   transform(lang.begin(), lang.end(), lang.begin(), ::tolower);
   //checking for non alphabetic char
-  if(len == 3 && std::regex_match(lang, std::regex("^[A-Za-z]+$"))){
-    if(namesMap.count(lang) > 0){
-      namesMap.erase(lang);
+  if(len == 3 && std::all_of(lang.begin(), lang.end(),
+      [](unsigned char c){ return std::isalpha(c); })){
+    auto it = namesMap.find(std::string_view(lang));
+    if(it == namesMap.end()){
+      namesMap.emplace(lang, name);
+    }else{
+      it->second.assign(name);
     }
-    namesMap.emplace(lang, name);
   }else{
     throw std::invalid_argument("Area::setName: Language code must be three alphabetical letters only");
   }
@@ -160,19 +196,54 @@ void Area::setName(std::string lang, std::string name){
 Measure& Area::getMeasure(std::string codename){
   //changing codename to lower case
   transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
-  if(measures.count(codename) > 0){
-    return measures.find(codename)->second;
-  }else{
+  auto it = measures.find(codename);
+  if(it == measures.end()){
     throw std::out_of_range("No measure found matching " +codename);
   }
+  return it->second;
 }
-// this function just returns a bool wether the measure exists not a ref 
-bool Area::checkMeasure(std::string codename){
+
+const Measure& Area::getMeasure(std::string codename) const{
   transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
-  if(this->measures.count(codename) > 0){
-    return true;
+  auto it = measures.find(codename);
+  if(it == measures.end()){
+    throw std::out_of_range("No measure found matching " +codename);
   }
-  return false;
+  return it->second;
+}
+// this function just returns a bool wether the measure exists not a ref 
+bool Area::checkMeasure(std::string codename) const{
+  return findMeasure(codename) != nullptr;
+}
+
+/*
+  Area::findMeasure(codename)
+
+  Look up a Measure by its codename, in any case, without throwing. Unlike
+  checking for the Measure with checkMeasure() and then fetching it with
+  getMeasure(), this is a single lookup.
+
+  @param codename
+    The codename for the measure you want to find
+
+  @return
+    A pointer to the Measure, or nullptr if this Area does not have it
+
+  @example
+    Area area("W06000023");
+    ...
+    const Measure* pop = area.findMeasure("Pop");
+    if(pop != nullptr){
+      std::cout << pop->getAverage();
+    }
+*/
+const Measure* Area::findMeasure(std::string_view codename) const{
+  // lowercased in a reused buffer, so that looking up does not allocate
+  thread_local std::string key;
+  key.assign(codename);
+  transform(key.begin(), key.end(), key.begin(), ::tolower);
+  auto it = measures.find(key);
+  return it == measures.end() ? nullptr : &it->second;
 }
 /*
   TODO: Area::setMeasure(codename, measure)
@@ -207,18 +278,171 @@ bool Area::checkMeasure(std::string codename){
     area.setMeasure(codename, measure);
 */
 
-void Area::setMeasure(std::string codename, Measure measure){
+void Area::setMeasure(std::string codename, const Measure& measure){
   //changing codename to lower case
   transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
-  if(measures.count(codename) > 0){
+  auto it = measures.find(codename);
+  if(it != measures.end()){
     //merging existing measure with new measure
-    Measure& existingMeasure = this->getMeasure(codename);
-    std::map<int, double> newValues = measure.getAll();
-    for (auto const& x : newValues){
-      existingMeasure.setValue(x.first,x.second);
-    }
+    it->second.merge(measure);
+  }else{
+    measures.emplace_hint(it, Symbol(codename), measure);
+  }
+}
+
+void Area::setMeasure(std::string codename, Measure&& measure){
+  transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
+  auto it = measures.find(codename);
+  if(it != measures.end()){
+    it->second.merge(std::move(measure));
+  }else{
+    measures.emplace_hint(it, Symbol(codename), std::move(measure));
+  }
+}
+
+// as setMeasure(), for a codename that is already a lowercase Symbol, such as
+// the key of another Area's Measure, so that it is not interned again
+void Area::mergeMeasure(Symbol codename, const Measure& measure){
+  auto it = measures.lower_bound(codename);
+  if(it != measures.end() && it->first == codename){
+    it->second.merge(measure);
+  }else{
+    measures.emplace_hint(it, codename, measure);
+  }
+}
+
+void Area::mergeMeasure(Symbol codename, Measure&& measure){
+  auto it = measures.lower_bound(codename);
+  if(it != measures.end() && it->first == codename){
+    it->second.merge(std::move(measure));
+  }else{
+    measures.emplace_hint(it, codename, std::move(measure));
   }
-    measures.emplace(codename, measure);
+}
+
+/*
+  Area::upsertValue(codename, label, year, value)
+
+  Set a single year's value for a Measure in this Area, creating the Measure
+  with the given label if it does not exist yet. Unlike fetching, modifying and
+  then passing a Measure to setMeasure(), the value is written straight into
+  the stored Measure, so nothing is copied.
+
+  If the Measure already exists, its label is left unchanged. Given strings,
+  the codename and label are only interned if the Measure is created; the
+  parsers pass Symbols from a SymbolCache instead, which are used as they are.
+
+  @param codename
+    The codename for the Measure, which is converted to lowercase for its key
+
+  @param label
+    The label to use if the Measure has to be created
+
+  @param year
+    The year to set the value for
+
+  @param value
+    The value for the given year
+
+  @example
+    Area area("W06000023");
+    area.upsertValue("pop", "Population", 1999, 12345678.9);
+*/
+void Area::upsertValue(
+    const std::string& codename,
+    const std::string& label,
+    int year,
+    double value){
+  // the lowercase key is only interned when a new Measure is created, so
+  // setting a value for an existing Measure does not allocate
+  thread_local std::string key;
+  key.assign(codename);
+  transform(key.begin(), key.end(), key.begin(), ::tolower);
+  auto it = measures.lower_bound(key);
+  if(it == measures.end() || it->first != key){
+    it = measures.emplace_hint(it,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(Symbol(key)),
+                               std::forward_as_tuple(codename, label));
+  }
+  it->second.setValue(year, value);
+}
+
+void Area::upsertValue(Symbol codename, Symbol label, int year, double value){
+  thread_local std::string key;
+  key.assign(codename);
+  transform(key.begin(), key.end(), key.begin(), ::tolower);
+  auto it = measures.lower_bound(key);
+  if(it == measures.end() || it->first != key){
+    // the parsers' codenames are already lowercase, so are their own keys
+    it = measures.emplace_hint(it,
+                               std::piecewise_construct,
+                               std::forward_as_tuple(key == codename
+                                                         ? codename
+                                                         : Symbol(key)),
+                               std::forward_as_tuple(codename, label));
+  }
+  it->second.setValue(year, value);
+}
+
+/*
+  Area::merge(other)
+
+  Combine another Area into this one. Names from other replace names in this
+  Area with the same language code, and measures are combined as in
+  setMeasure(). The rvalue overload moves names and measures out of other
+  rather than copying them.
+
+  @param other
+    The Area to merge into this one
+
+  @example
+    Area area("W06000023");
+    Area update("W06000023");
+    update.setName("eng", "Powys");
+    area.merge(std::move(update));
+*/
+void Area::merge(const Area& other){
+  for(const auto& x : other.namesMap){
+    namesMap[x.first] = x.second;
+  }
+  for(const auto& x : other.measures){
+    mergeMeasure(x.first, x.second);
+  }
+}
+
+void Area::merge(Area&& other){
+  for(auto& x : other.namesMap){
+    namesMap[x.first] = std::move(x.second);
+  }
+  for(auto& x : other.measures){
+    mergeMeasure(x.first, std::move(x.second));
+  }
+  other.namesMap.clear();
+  other.measures.clear();
+}
+
+/*
+  Area::mergeMeasures(other)
+
+  Combine the measures of another Area into this one, as in merge(), but leave
+  the names of this Area untouched.
+
+  @param other
+    The Area whose measures are moved into this one
+
+  @example
+    Area area("W06000023");
+    area.setName("eng", "Powys");
+    Area update("W06000023");
+    update.setName("eng", "Powys County");
+    area.mergeMeasures(std::move(update)); // still named Powys
+*/
+void Area::mergeMeasures(Area&& other){
+  for(auto& x : other.measures){
+    mergeMeasure(x.first, std::move(x.second));
+  }
+  other.measures.clear();
 }
 
 /*
@@ -244,27 +468,59 @@ void Area::setMeasure(std::string codename, Measure measure){
     area.setMeasure(code, measure);
     auto size = area.size();
 */
-int Area::size(){
+int Area::size() const{
   if(measures.empty()){
     return 0;
   }else{
     return measures.size();
   }
 }
-std::map<std::string, std::string> Area::getAllNames(){
-  std::map<std::string, std::string> map;
-  for (auto const& x : this->namesMap){
-    map.emplace(x.first,x.second);
+/*
+  Area::getAllNames() / Area::getAllMeasures()
+
+  Copy the names or measures of this Area into a new std::map. Prefer
+  getNamesView() and getMeasuresView(), which do not copy anything.
+
+  @return
+    A copy of the names (keyed by language code) or measures (keyed by
+    codename) for this Area
+*/
+std::map<std::string, std::string> Area::getAllNames() const{
+  std::map<std::string, std::string> names;
+  for(const auto& x : namesMap){
+    names.emplace(x.first, x.second);
   }
-  return map;
+  return names;
 }
 
-std::map<std::string, Measure> Area::getAllMeasures(){
-  std::map<std::string, Measure> map;
-  for (auto const& x : this->measures){
-    map.emplace(x.first,x.second);
-  }
-  return map;
+std::map<std::string, Measure> Area::getAllMeasures() const{
+  return std::map<std::string, Measure>(measures.begin(), measures.end());
+}
+
+/*
+  Area::getNamesView() / Area::getMeasuresView()
+
+  Retrieve read-only access to the names or measures of this Area, so they can
+  be walked in order without copying. The references are valid until the Area
+  is next modified or destroyed.
+
+  @return
+    A constant reference to the names (keyed by language code) or measures
+    (keyed by codename) inside this Area
+
+  @example
+    Area area("W06000023");
+    area.setName("eng", "Powys");
+    for(const auto& name : area.getNamesView()){
+      ...
+    }
+*/
+const NamesContainer& Area::getNamesView() const noexcept{
+  return namesMap;
+}
+
+const MeasuresContainer& Area::getMeasuresView() const noexcept{
+  return measures;
 }
 /*
   TODO: operator<<(os, area)
@@ -281,6 +537,9 @@ std::map<std::string, Measure> Area::getAllMeasures(){
   Measures should be ordered by their Measure codename. If there are no measures
   output the line "<no measures>" after you have output the area names.
 
+  The names are output as "<English name> / <Welsh name> (<code>)", and each
+  Measure, or the "<no measures>" line, is followed by a blank line.
+
   See the coursework specification for more examples.
 
   @param os
@@ -297,17 +556,42 @@ std::map<std::string, Measure> Area::getAllMeasures(){
     area.setName("eng", "Powys");
     std::cout << area << std::endl;
 */
-std::ostream& operator<<(std::ostream &os, Area area){
-  auto names = area.getAllNames();
-  auto measures = area.getAllMeasures();
-  for(const auto& x: names){
-    os<<x.second;
-    os<<" / ";
+std::ostream& operator<<(std::ostream &os, const Area& area){
+  thread_local std::string header;
+  header.clear();
+  auto addName = [](std::string_view name) {
+    if(!header.empty()){
+      header += " / ";
+    }
+    header += name;
+  };
+
+  // English then Welsh, falling back to any other names there are
+  const NamesContainer& names = area.getNamesView();
+  for(const char* lang : {"eng", "cym"}){
+    auto it = names.find(lang);
+    if(it != names.end()){
+      addName(it->second);
+    }
+  }
+  if(header.empty()){
+    for(const auto& x : names){
+      addName(x.second);
+    }
+  }
+  if(header.empty()){
+    header = "Unnamed";
+  }
+  header += " (";
+  header += area.getLocalAuthorityCode();
+  header += ")\n";
+  os.write(header.data(), header.size());
+
+  if(area.getMeasuresView().empty()){
+    os << "<no measures>\n\n";
   }
-  os<<area.getLocalAuthorityCode();
-  os<<"\n";
-  for(const auto& x: measures){
-    os<<x.second;
+  for(const auto& x : area.getMeasuresView()){
+    os << x.second << '\n';
   }
   return os;
 }
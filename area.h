@@ -17,8 +17,25 @@
  */
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <memory_resource>
 #include "measure.h"
+#include "symbol.h"
+
+/*
+  Aliases for the containers inside an Area. Read-only views of these are
+  handed out by getNamesView() and getMeasuresView(). Measures are keyed by
+  their interned codenames, and can be looked up by any string type.
+
+  Both are std::pmr containers, so an Area (which is allocator-aware) keeps
+  its names and measures in the memory resource it was created with. The
+  names are std::pmr::strings, so that their characters come from the same
+  resource as the nodes that hold them.
+*/
+using NamesContainer =
+    std::pmr::map<std::pmr::string, std::pmr::string, std::less<>>;
+using MeasuresContainer = std::pmr::map<Symbol, Measure, std::less<>>;
 
 /*
   An Area object consists of a unique authority code, a container for names
@@ -31,22 +48,50 @@
 */
 class Area {
   private:
-    std::string localAuthorityCode;
-    std::map <std::string, std::string> namesMap;
-    std::map <std::string, Measure> measures;
+    Symbol localAuthorityCode;
+    NamesContainer namesMap;
+    MeasuresContainer measures;
+
+    void mergeMeasure(Symbol codename, const Measure& measure);
+    void mergeMeasure(Symbol codename, Measure&& measure);
   public:
-    Area(const std::string& localAuthorityCode);
-    std::string getLocalAuthorityCode();
-    std::string getName(std::string langCode);
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    Area(Symbol localAuthorityCode,
+         const allocator_type& alloc = {});
+    explicit Area(const std::string& localAuthorityCode,
+                  const allocator_type& alloc = {});
+    Area(const Area& other) = default;
+    Area(Area&& other) = default;
+    Area(const Area& other, const allocator_type& alloc);
+    Area(Area&& other, const allocator_type& alloc);
+    Area& operator=(const Area& other) = default;
+    Area& operator=(Area&& other) = default;
+    const std::string& getLocalAuthorityCode() const noexcept;
+    std::string getName(std::string langCode) const;
     void setName(std::string lang, std::string name);
     Measure& getMeasure(std::string key);
-    void setMeasure(std::string codename, Measure measure);
-    bool checkMeasure(std::string codename);
-    int size();
-    std::map<std::string, std::string> getAllNames();
-    std::map<std::string, Measure> getAllMeasures();
+    const Measure& getMeasure(std::string key) const;
+    void setMeasure(std::string codename, const Measure& measure);
+    void setMeasure(std::string codename, Measure&& measure);
+    void upsertValue(
+        const std::string& codename,
+        const std::string& label,
+        int year,
+        double value);
+    void upsertValue(Symbol codename, Symbol label, int year, double value);
+    void merge(const Area& other);
+    void merge(Area&& other);
+    void mergeMeasures(Area&& other);
+    bool checkMeasure(std::string codename) const;
+    const Measure* findMeasure(std::string_view codename) const;
+    int size() const;
+    std::map<std::string, std::string> getAllNames() const;
+    std::map<std::string, Measure> getAllMeasures() const;
+    const NamesContainer& getNamesView() const noexcept;
+    const MeasuresContainer& getMeasuresView() const noexcept;
 
-    friend std::ostream& operator<<(std::ostream &os, Area area);
+    friend std::ostream& operator<<(std::ostream &os, const Area& area);
     friend bool operator==(const Area& lhs, const Area& rhs);
 };
 
@@ -26,11 +26,21 @@
 #include <unordered_set>
 #include <typeinfo>
 #include <sstream>
+#include <string_view>
+#include <functional>
+#include <future>
+#include <algorithm>
+#include <vector>
+#include <charconv>
+#include <climits>
+#include <cmath>
 
 #include "lib_json.hpp"
+#include "csv.h"
 #include "datasets.h"
 #include "areas.h"
 #include "measure.h"
+#include "trace.h"
 
 /*
   An alias for the imported JSON parsing library.
@@ -50,6 +60,104 @@ Areas::Areas() {
   //throw std::logic_error("Areas::Areas() has not been implemented!");
 }
 
+namespace {
+
+// The size of the arena's first block; each later block is larger
+const std::size_t ARENA_BLOCK_SIZE = 64 * 1024;
+
+} // namespace
+
+/*
+  Areas::Areas(allocation)
+
+  Construct an Areas object that allocates from the heap, as Areas() does, or
+  from an arena of its own that is released in one go when it is destroyed.
+
+  @param allocation
+    Areas::Arena to give the Areas object its own arena, or Areas::Heap
+
+  @example
+    Areas data(Areas::Arena);
+*/
+Areas::Areas(Allocation allocation)
+    : arena(allocation == Arena
+                ? std::make_unique<std::pmr::monotonic_buffer_resource>(ARENA_BLOCK_SIZE)
+                : nullptr),
+      areasContainer(arena ? static_cast<std::pmr::memory_resource*>(arena.get())
+                           : std::pmr::get_default_resource()) {}
+
+/*
+  Areas::Areas(resource)
+
+  Construct an Areas object that allocates from a memory resource it does not
+  own, such as the arena of another Areas object, which must outlive it.
+
+  @param resource
+    The memory resource to allocate from
+
+  @example
+    Areas data(Areas::Arena);
+    Areas partial(data.getResource());
+    ...
+    data.merge(std::move(partial)); // moves partial's Areas without copying
+*/
+Areas::Areas(std::pmr::memory_resource* resource) : areasContainer(resource) {}
+
+/*
+  Areas copy and move
+
+  A copy has its own arena if the original has one. Moving an Areas object
+  moves its arena with it, so the moved-from object should only be destroyed.
+  Assigning to an Areas object copies or moves the Areas into its own memory,
+  keeping its arena.
+*/
+Areas::Areas(const Areas& other) : Areas(other.usesArena() ? Arena : Heap) {
+  areasContainer = other.areasContainer;
+  importCounts = other.importCounts;
+}
+
+Areas::Areas(Areas&& other) noexcept
+    : arena(std::move(other.arena)),
+      areasContainer(std::move(other.areasContainer)),
+      importCounts(other.importCounts) {
+  other.sortedAreasValid = false;
+}
+
+Areas& Areas::operator=(const Areas& other) {
+  areasContainer = other.areasContainer;
+  importCounts = other.importCounts;
+  sortedAreasValid = false;
+  return *this;
+}
+
+Areas& Areas::operator=(Areas&& other) {
+  areasContainer = std::move(other.areasContainer);
+  importCounts = other.importCounts;
+  sortedAreasValid = false;
+  other.sortedAreasValid = false;
+  return *this;
+}
+
+/*
+  Areas::usesArena()
+
+  @return
+    True if the Areas object allocates from its own arena
+*/
+bool Areas::usesArena() const noexcept {
+  return arena != nullptr;
+}
+
+/*
+  Areas::getResource()
+
+  @return
+    The memory resource the Areas object allocates from
+*/
+std::pmr::memory_resource* Areas::getResource() const noexcept {
+  return areasContainer.get_allocator().resource();
+}
+
 /*
   TODO: Areas::setArea(localAuthorityCode, area)
 
@@ -75,29 +183,178 @@ Areas::Areas() {
     Area area(localAuthorityCode);
     data.setArea(localAuthorityCode, area);
 */
+void Areas::setArea(std::string localAuthorityCode, const Area& area){
+  auto it = findArea(localAuthorityCode);
+  if(it != areasContainer.end()){
+    it->second.merge(area);
+  }else{
+    areasContainer.emplace(Symbol(localAuthorityCode), area);
+    sortedAreasValid = false;
+  }
+}
+
+void Areas::setArea(std::string localAuthorityCode, Area&& area){
+  auto it = findArea(localAuthorityCode);
+  if(it != areasContainer.end()){
+    it->second.merge(std::move(area));
+  }else{
+    areasContainer.emplace(Symbol(localAuthorityCode), std::move(area));
+    sortedAreasValid = false;
+  }
+}
+
+// finds an Area by its code without interning the code, as a code that has
+// never been interned cannot belong to any Area
+AreasContainer::iterator Areas::findArea(std::string_view localAuthorityCode){
+  auto symbol = Symbol::find(localAuthorityCode);
+  return symbol ? areasContainer.find(*symbol) : areasContainer.end();
+}
+
+AreasContainer::const_iterator Areas::findArea(
+    std::string_view localAuthorityCode) const{
+  auto symbol = Symbol::find(localAuthorityCode);
+  return symbol ? areasContainer.find(*symbol) : areasContainer.end();
+}
+
+/*
+  Areas::merge(other)
+
+  Move every Area from another Areas instance into this one, as if the data
+  that populated other had been passed to populate() on this instance
+  instead. Measure values from other take precedence, but names are only
+  taken from other for an Area that has no names here yet, in the same way
+  that populateFromWelshStatsJSON() only names Areas that are unnamed.
+
+  Merging the results of several populate() calls in the order they would
+  have been made therefore gives the same data as making the calls in turn.
+
+  @param other
+    The Areas instance to empty into this one
+
+  @example
+    Areas data = Areas();
+    Areas popData = Areas();
+    popData.populate(input.open(), BethYw::WelshStatsJSON, cols);
+    data.merge(std::move(popData));
+*/
+void Areas::merge(Areas&& other){
+  BETHYW_TRACE_SCOPE("Areas::merge");
+  for(auto& x : other.areasContainer){
+    auto it = areasContainer.find(x.first);
+    if(it == areasContainer.end()){
+      areasContainer.emplace(x.first, std::move(x.second));
+      sortedAreasValid = false;
+    }else if(it->second.getNamesView().empty()){
+      it->second.merge(std::move(x.second));
+    }else{
+      it->second.mergeMeasures(std::move(x.second));
+    }
+  }
+  other.areasContainer.clear();
+  other.sortedAreasValid = false;
+
+  importCounts.rowsParsed += other.importCounts.rowsParsed;
+  importCounts.rowsFiltered += other.importCounts.rowsFiltered;
+  other.importCounts = ImportCounts();
+}
+
 /*
-if(measures.count(codename) > 0){
-    Measure& existingMeasure = this->getMeasure(codename);
+  Areas::select(filter)
+
+  Copy what passes the filters into a new Areas instance, as if the data that
+  populated this instance had been populated with the filters instead. An
+  Area with Measures is only copied if one of its values passes the filters,
+  and then only with the Measures and values that do. An Area with only names
+  (i.e. from areas.csv) is copied if its local authority code passes.
+
+  Merging the selections from several Areas instances, in the order they
+  were populated, therefore gives the same data as populating one Areas
+  instance with the filters. This lets the data be loaded once and then
+  filtered many times (see QueryServer).
 
-    std::map<int, double> newValues = measure.getAll();
-    for (auto const& x : newValues){
-      existingMeasure.setValue(x.first,x.second);
+  @param filter
+    The filters to apply
+
+  @return
+    A new Areas instance, with its own arena, holding the selection
+
+  @example
+    Areas all(Areas::Arena);
+    BethYw::loadAreas(all, "datasets/", FilterSpec());
+
+    StringFilterSet areasFilter = {"W06000011"};
+    Areas swansea = all.select(FilterSpec(&areasFilter, nullptr, nullptr));
+*/
+Areas Areas::select(const FilterSpec& filter) const{
+  Areas selected(Areas::Arena);
+  for(const auto& x : areasContainer){
+    const Area& area = x.second;
+    if(!filter.acceptsArea(area.getLocalAuthorityCode())){
+      continue;
     }
-} */
-void Areas::setArea(std::string localAuthorityCode, Area area){
-  if(areasContainer.count(localAuthorityCode) > 0){
-    Area& existingArea = this->getArea(localAuthorityCode);
-    std::map<std::string, std::string> newNamesMap = area.getAllNames();
-    std::map<std::string, Measure> newMeasuresMap = area.getAllMeasures();
 
-    for(auto const& x : newNamesMap){
-      existingArea.setName(x.first, x.second);
+    // the Area is only created once it has something to hold
+    Area* copy = nullptr;
+    auto createCopy = [&]() {
+      if(copy == nullptr){
+        copy = &selected.findOrCreateArea(x.first);
+        for(const auto& name : area.getNamesView()){
+          copy->setName(std::string(name.first), std::string(name.second));
+        }
+      }
+    };
+
+    if(area.getMeasuresView().empty()){
+      createCopy();
+      continue;
     }
-    for(auto const& x: newMeasuresMap){
-      existingArea.setMeasure(x.first, x.second);
+    for(const auto& y : area.getMeasuresView()){
+      const Measure& measure = y.second;
+      if(!filter.acceptsMeasure(measure.getCodename())){
+        continue;
+      }
+      for(const auto& value : measure){
+        if(filter.acceptsYear(value.first)){
+          createCopy();
+          copy->upsertValue(measure.getCodenameSymbol(),
+                            measure.getLabelSymbol(),
+                            value.first, value.second);
+        }
+      }
     }
   }
-  this->areasContainer.emplace(localAuthorityCode,area);
+  return selected;
+}
+
+/*
+  Areas::findOrCreateArea(localAuthorityCode)
+
+  Retrieve the Area with a given local authority code, inserting an empty
+  Area for it first if there is not one already. This is a single lookup,
+  unlike checking for the Area and then calling setArea() and getArea().
+
+  The code is interned once, and the same Symbol keys the Area and is stored
+  in it. Parsers pass a Symbol from their own SymbolCache, so most rows do
+  not go to the symbol table at all.
+
+  @param localAuthorityCode
+    The local authority code of the Area
+
+  @return
+    A reference to the Area stored in this Areas instance
+
+  @example
+    Areas data = Areas();
+    Area& area = data.findOrCreateArea("W06000023");
+    area.upsertValue("pop", "Population", 1999, 12345678.9);
+*/
+Area& Areas::findOrCreateArea(Symbol localAuthorityCode){
+  auto inserted = areasContainer.try_emplace(localAuthorityCode,
+                                             localAuthorityCode);
+  if(inserted.second){
+    sortedAreasValid = false;
+  }
+  return inserted.first->second;
 }
 
 /*
@@ -124,20 +381,85 @@ void Areas::setArea(std::string localAuthorityCode, Area area){
     Area area2 = areas.getArea("W06000023");
 */
 Area& Areas::getArea(std::string localAuthorityCode){
-  if(areasContainer.count(localAuthorityCode) > 0){
-    return areasContainer.find(localAuthorityCode)->second;
-  }else{
+  auto it = findArea(localAuthorityCode);
+  if(it == areasContainer.end()){
     throw std::out_of_range("No area found matching " + localAuthorityCode);
   }
-  
+  return it->second;
+}
+
+const Area& Areas::getArea(std::string localAuthorityCode) const{
+  auto it = findArea(localAuthorityCode);
+  if(it == areasContainer.end()){
+    throw std::out_of_range("No area found matching " + localAuthorityCode);
+  }
+  return it->second;
+}
+
+/*
+  Areas::getAllAreas()
+
+  Copy every Area into a new std::map. Prefer getAreasView(), which does not
+  copy anything.
+
+  @return
+    A copy of the Area instances, keyed by local authority code
+*/
+std::map<std::string, Area> Areas::getAllAreas() const{
+  return std::map<std::string, Area>(areasContainer.begin(), areasContainer.end());
 }
 
-std::map<std::string, Area> Areas::getAllAreas(){
-  std::map<std::string, Area> map;
-  for (auto const& x : this->areasContainer){
-    map.emplace(x.first,x.second);
+/*
+  Areas::getAreasView()
+
+  Retrieve read-only access to the Area instances, ordered by local authority
+  code, so they can be walked without copying. The view is valid until the
+  Areas instance is next modified or destroyed.
+
+  The order is only worked out when it is first needed after an Area has been
+  added, and is then kept, so lookups while importing never pay for it. This
+  is safe to call from several threads at once.
+
+  @return
+    An AreasView of the entries in the underlying AreasContainer
+
+  @example
+    Areas data = Areas();
+    ...
+    for(const auto& area : data.getAreasView()){
+      ...
+    }
+*/
+AreasView Areas::getAreasView() const{
+  if(!sortedAreasValid.load(std::memory_order_acquire)){
+    std::lock_guard<std::mutex> lock(sortedAreasMutex);
+    if(!sortedAreasValid.load(std::memory_order_relaxed)){
+      sortedAreas.clear();
+      sortedAreas.reserve(areasContainer.size());
+      for(const auto& area : areasContainer){
+        sortedAreas.push_back(&area);
+      }
+      std::sort(sortedAreas.begin(), sortedAreas.end(),
+                [](const AreasView::value_type* lhs, const AreasView::value_type* rhs) {
+                  return lhs->first < rhs->first;
+                });
+      sortedAreasValid.store(true, std::memory_order_release);
+    }
   }
-  return map;
+  return AreasView(sortedAreas);
+}
+
+/*
+  operator==(lhs, rhs)
+
+  Two AreasViews are equal if they have equal Areas under the same local
+  authority codes.
+*/
+bool operator==(const AreasView& lhs, const AreasView& rhs){
+  return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                    [](const AreasView::value_type& l, const AreasView::value_type& r) {
+                      return l.first == r.first && l.second == r.second;
+                    });
 }
 /*
   TODO: Areas::size()
@@ -157,10 +479,131 @@ std::map<std::string, Area> Areas::getAllAreas(){
     
     auto size = areas.size(); // returns 1
 */
-int Areas::size(){
+int Areas::size() const{
   return areasContainer.size();
 }
 
+/*
+  Areas::getImportCounts()
+
+  @return
+    The number of rows read and filtered out by the populate functions of
+    this Areas instance, including those of any Areas merged into it
+
+  @example
+    Areas data = Areas();
+    data.populate(is, BethYw::AuthorityCodeCSV, cols, filter);
+    auto rows = data.getImportCounts().rowsParsed;
+*/
+const ImportCounts& Areas::getImportCounts() const noexcept {
+  return importCounts;
+}
+
+/*
+  Areas::getMeasureTotals(codename)
+
+  Total a measure across every Area that has it, year by year. A year for
+  which an Area has no value counts as 0 for that Area.
+
+  @param codename
+    The codename of the measure to total, which is case-insensitive
+
+  @return
+    A Measure with the total for each year, labelled like the first Area's
+    Measure, or an empty Measure if no Area has the measure. The codename is
+    not interned to build the Measure, so if no Area has ever had the
+    measure, the Measure has no codename either
+
+  @example
+    Areas data = Areas();
+    ...
+    auto totals = data.getMeasureTotals("pop"); // the population of Wales
+*/
+Measure Areas::getMeasureTotals(std::string codename) const{
+  std::transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
+  const auto key = Symbol::find(codename);
+  Measure totals(key.value_or(Symbol()), Symbol());
+  if(!key){
+    return totals;
+  }
+  bool labelled = false;
+  for(const auto& area : getAreasView()){
+    const Measure* measure = area.second.findMeasure(codename);
+    if(measure != nullptr){
+      if(!labelled){
+        totals.setLabel(measure->getLabelSymbol());
+        labelled = true;
+      }
+      totals.accumulate(*measure);
+    }
+  }
+  return totals;
+}
+
+/*
+  Areas::getMeasureSummary(codename)
+
+  Summarise the values of a measure across every year of every Area that has
+  it, by combining the Summary of each Area's Measure.
+
+  @param codename
+    The codename of the measure to summarise, which is case-insensitive
+
+  @return
+    The Stats::Summary of all the values, which is empty (all 0) if no Area
+    has the measure
+
+  @example
+    Areas data = Areas();
+    ...
+    auto summary = data.getMeasureSummary("pop");
+    std::cout << summary.mean << " +/- " << std::sqrt(summary.variance);
+*/
+Stats::Summary Areas::getMeasureSummary(std::string codename) const{
+  Stats::Summary summary;
+  for(const auto& area : getAreasView()){
+    const Measure* measure = area.second.findMeasure(codename);
+    if(measure != nullptr){
+      summary = Stats::combine(summary, measure->getSummary());
+    }
+  }
+  return summary;
+}
+
+namespace {
+
+/*
+  Find the index of a named column in the header row of a CSV file.
+*/
+std::size_t findCSVColumn(
+    const std::vector<std::string_view>& header,
+    const std::string& name) {
+  for(std::size_t i = 0; i < header.size(); i++){
+    if(header[i] == name){
+      return i;
+    }
+  }
+  throw std::runtime_error("Areas: CSV file is missing column " + name);
+}
+
+/*
+  Convert a CSV field to a number without copying it into a std::string,
+  rejecting fields that are not entirely numeric.
+*/
+template <typename T>
+T parseCSVNumber(std::string_view field, std::size_t row) {
+  T value = 0;
+  const char* end = field.data() + field.size();
+  auto result = std::from_chars(field.data(), end, value);
+  if(result.ec != std::errc() || result.ptr != end){
+    throw std::runtime_error("Areas: Invalid number '" + std::string(field)
+                             + "' on row " + std::to_string(row) + " of CSV file");
+  }
+  return value;
+}
+
+} // namespace
+
 /*
   TODO: Areas::populateFromAuthorityCodeCSV(is, cols, areasFilter)
 
@@ -177,6 +620,10 @@ int Areas::size(){
   Once the data is parsed, you need to create the appropriate Area objects and
   insert them in to a Standard Library container within Areas.
 
+  Rows are read one at a time with CSVReader and inserted straight away, so
+  only the current row is ever held in memory. The columns are located by
+  their names in the header row.
+
   @param is
     The input stream from InputSource
 
@@ -216,35 +663,479 @@ void Areas::populateFromAuthorityCodeCSV(
     std::istream &is,
     const BethYw::SourceColumnMapping &cols,
     const StringFilterSet * const areasFilter) {
-      // reading the csv into a stringstream, to put commas at the new lines
-      // then reading the stringstream into a vector using the commas as delimiters
-      std::string line;
-      std::vector<std::string> result;
-      while(getline(is, line)){
-        std::stringstream ss(line);
-        while(getline(ss, line,',')){
-          result.push_back(line);
+      CSVReader reader(is);
+      populateFromAuthorityCodeCSV(
+          reader, cols, FilterSpec(areasFilter, nullptr, nullptr));
+}
+
+void Areas::populateFromAuthorityCodeCSV(
+    CSVReader &reader,
+    const BethYw::SourceColumnMapping &cols,
+    const FilterSpec &filter) {
+      BETHYW_TRACE_SCOPE("Areas::populateFromAuthorityCodeCSV");
+      if(!reader.nextRow()){
+        throw std::runtime_error(
+            "Areas::populateFromAuthorityCodeCSV: File has no header row");
+      }
+      // find where each of our columns is in the header row
+      const std::size_t codeColumn =
+          findCSVColumn(reader.fields(), cols.at(BethYw::AUTH_CODE));
+      const std::size_t engColumn =
+          findCSVColumn(reader.fields(), cols.at(BethYw::AUTH_NAME_ENG));
+      const std::size_t cymColumn =
+          findCSVColumn(reader.fields(), cols.at(BethYw::AUTH_NAME_CYM));
+      const std::size_t columns = reader.fields().size();
+
+      SymbolCache symbols;
+      while(reader.nextRow()){
+        const auto& fields = reader.fields();
+        if(fields.size() != columns){
+          throw std::runtime_error(
+              "Areas::populateFromAuthorityCodeCSV: Wrong number of columns "
+              "on row " + std::to_string(reader.getRowNumber()));
         }
-      }   
-      //std::cout<<cols.size();
-      int sizeOfResult = static_cast<int>(result.size());
-      // we know that starting from the 3rd element every 3rd element will be
-      // an area code and then +1 from the code is the english name and 
-      // +2 from the code is the welsh name
-      
-      // i choose not to use cols to eliminate the column headers from as the
-      // columns will always be in the same order.
-      for(int i =3;i<sizeOfResult-2;i=i+3){
-        auto localAuthorityCode = result.at(i);
-        Area area(localAuthorityCode);
-        area.setName("eng", result.at(i+1));
-        area.setName("cym", result.at(i+2));
-        setArea(localAuthorityCode, area);
+        importCounts.rowsParsed++;
+        if(!filter.acceptsArea(fields[codeColumn])){
+          importCounts.rowsFiltered++;
+          continue;
+        }
+        // named in place, so the Area is created in this Areas' memory
+        Area& area = findOrCreateArea(symbols.get(fields[codeColumn]));
+        area.setName("eng", std::string(fields[engColumn]));
+        area.setName("cym", std::string(fields[cymColumn]));
       }
-      std::cout<<this->size();
 }
 
 
+/*
+  A SAX event handler for nlohmann::json that walks the "value" array of a
+  StatsWales JSON file one row at a time, so the document is never held in
+  memory as a DOM. The keys of the columns named in cols are looked up once,
+  and only those columns are kept from each row; when the closing brace of a
+  row is reached the row is passed to the callback and the buffers are reused
+  for the next row.
+
+  The area code, year and measure code of a row are each checked against
+  their filter as soon as they are read. Once a row has failed a filter the
+  rest of its fields are only noted as present, and its value is never
+  converted.
+
+  Any nested objects or arrays inside a row, and every top-level key other
+  than "value", are skipped over.
+*/
+namespace {
+
+struct WelshStatsRow {
+  std::string authCode;
+  std::string authNameEng;
+  std::string measureCode;
+  std::string measureName;
+  std::string valueString;
+  int year = 0;
+  double value = 0;
+  bool valueIsString = false;
+  bool rejected = false;
+  unsigned int seen = 0;
+};
+
+class WelshStatsSAXHandler : public nlohmann::json_sax<json> {
+  public:
+    enum Slot : unsigned int {
+      SLOT_AUTH_CODE     = 1 << 0,
+      SLOT_AUTH_NAME_ENG = 1 << 1,
+      SLOT_MEASURE_CODE  = 1 << 2,
+      SLOT_MEASURE_NAME  = 1 << 3,
+      SLOT_YEAR          = 1 << 4,
+      SLOT_VALUE         = 1 << 5
+    };
+
+    // With rowsOnly, each document parsed is a single row of the "value"
+    // array rather than a whole file
+    WelshStatsSAXHandler(
+        const BethYw::SourceColumnMapping &cols,
+        const FilterSpec &filter,
+        std::function<void(const WelshStatsRow&)> onRow,
+        bool rowsOnly = false)
+        : filter(filter), onRow(std::move(onRow)), inValueArray(rowsOnly) {
+      addColumn(cols, BethYw::AUTH_CODE,     SLOT_AUTH_CODE);
+      addColumn(cols, BethYw::AUTH_NAME_ENG, SLOT_AUTH_NAME_ENG);
+      addColumn(cols, BethYw::MEASURE_CODE,  SLOT_MEASURE_CODE);
+      addColumn(cols, BethYw::MEASURE_NAME,  SLOT_MEASURE_NAME);
+      addColumn(cols, BethYw::YEAR,          SLOT_YEAR);
+      addColumn(cols, BethYw::VALUE,         SLOT_VALUE);
+
+      // a file with a single measure is either wholly in or out of the filter
+      auto single = cols.find(BethYw::SINGLE_MEASURE_CODE);
+      if(cols.count(BethYw::MEASURE_CODE) == 0 && single != cols.end()){
+        std::string codename = single->second;
+        transform(codename.begin(), codename.end(), codename.begin(), ::tolower);
+        rejectAll = !filter.acceptsMeasure(codename);
+      }
+    }
+
+    bool null() override {
+      return true;
+    }
+
+    bool boolean(bool) override {
+      return true;
+    }
+
+    // every number is held as a double, which is exact for any year that
+    // fits in an int, so the year is range-checked in one place
+    bool number_integer(number_integer_t val) override {
+      return number(static_cast<double>(val));
+    }
+
+    bool number_unsigned(number_unsigned_t val) override {
+      return number(static_cast<double>(val));
+    }
+
+    bool number_float(number_float_t val, const string_t&) override {
+      return number(val);
+    }
+
+    bool string(string_t& val) override {
+      if(!inRowField()){
+        return true;
+      }
+      row.seen |= currentSlots;
+      if(row.rejected || currentSlots == 0){
+        return true;
+      }
+
+      // the filters first, so nothing is copied from a row that is rejected
+      if((currentSlots & SLOT_AUTH_CODE) && !filter.acceptsArea(val)){
+        row.rejected = true;
+        return true;
+      }
+      if(currentSlots & SLOT_YEAR){
+        row.year = parseYear(val);
+        if(!filter.acceptsYear(row.year)){
+          row.rejected = true;
+          return true;
+        }
+      }
+      if(currentSlots & SLOT_MEASURE_CODE){
+        row.measureCode.resize(val.size());
+        transform(val.begin(), val.end(), row.measureCode.begin(), ::tolower);
+        if(!filter.acceptsMeasure(row.measureCode)){
+          row.rejected = true;
+          return true;
+        }
+      }
+
+      if(currentSlots & SLOT_AUTH_CODE)     row.authCode = val;
+      if(currentSlots & SLOT_AUTH_NAME_ENG) row.authNameEng = val;
+      if(currentSlots & SLOT_MEASURE_NAME)  row.measureName = val;
+      if(currentSlots & SLOT_VALUE){
+        // converted only once the whole row has passed the filters
+        row.valueString = val;
+        row.valueIsString = true;
+      }
+      return true;
+    }
+
+    bool binary(binary_t&) override {
+      return true;
+    }
+
+    bool start_object(std::size_t) override {
+      depth++;
+      if(inValueArray && depth == valueDepth + 1){
+        row.seen = 0;
+        row.valueIsString = false;
+        row.rejected = rejectAll;
+        currentSlots = 0;
+      }
+      return true;
+    }
+
+    bool key(string_t& val) override {
+      if(inValueArray && depth == valueDepth + 1){
+        currentSlots = 0;
+        for(const auto& col : columns){
+          if(val == col.first){
+            currentSlots |= col.second;
+          }
+        }
+      }else if(depth == 1){
+        nextIsValueArray = (val == "value");
+      }
+      return true;
+    }
+
+    bool end_object() override {
+      if(inValueArray && depth == valueDepth + 1){
+        onRow(row);
+      }
+      depth--;
+      return true;
+    }
+
+    bool start_array(std::size_t) override {
+      depth++;
+      if(depth == 2 && nextIsValueArray){
+        inValueArray = true;
+        valueDepth = depth;
+      }
+      nextIsValueArray = false;
+      return true;
+    }
+
+    bool end_array() override {
+      if(inValueArray && depth == valueDepth){
+        inValueArray = false;
+      }
+      depth--;
+      return true;
+    }
+
+    bool parse_error(std::size_t,
+                     const std::string&,
+                     const nlohmann::detail::exception& ex) override {
+      throw std::runtime_error(
+          std::string("Areas::populateFromWelshStatsJSON: ") + ex.what());
+    }
+
+  private:
+    std::vector<std::pair<std::string, unsigned int>> columns;
+    const FilterSpec &filter;
+    std::function<void(const WelshStatsRow&)> onRow;
+    WelshStatsRow row;
+    bool inValueArray;
+    bool rejectAll = false;
+    unsigned int currentSlots = 0;
+    unsigned int depth = 0;
+    unsigned int valueDepth = 0;
+    bool nextIsValueArray = false;
+
+    void addColumn(const BethYw::SourceColumnMapping &cols,
+                   BethYw::SourceColumn column,
+                   unsigned int slot) {
+      auto it = cols.find(column);
+      if(it != cols.end()){
+        columns.emplace_back(it->second, slot);
+      }
+    }
+
+    // True when the next scalar is the value of a key directly inside a row
+    bool inRowField() const {
+      return inValueArray && depth == valueDepth + 1;
+    }
+
+    // Years are usually plain digits, which std::from_chars reads without
+    // the locale; anything else goes through std::stoi to be read (or
+    // rejected) as before
+    static int parseYear(const std::string& text) {
+      int year = 0;
+      const char* first = text.data();
+      const char* last = first + text.size();
+      auto result = std::from_chars(first, last, year);
+      if(result.ec == std::errc() && result.ptr == last){
+        return year;
+      }
+      return std::stoi(text);
+    }
+
+    bool number(double val) {
+      if(!inRowField()){
+        return true;
+      }
+      row.seen |= currentSlots & (SLOT_VALUE | SLOT_YEAR);
+      if(row.rejected){
+        return true;
+      }
+      if(currentSlots & SLOT_YEAR){
+        // also false for NaN, so the cast below is always defined
+        if(!(val >= INT_MIN && val <= INT_MAX && std::trunc(val) == val)){
+          throw std::runtime_error(
+              "Areas::populateFromWelshStatsJSON: Year is not a whole number");
+        }
+        row.year = static_cast<int>(val);
+        if(!filter.acceptsYear(row.year)){
+          row.rejected = true;
+          return true;
+        }
+      }
+      if(currentSlots & SLOT_VALUE){
+        row.value = val;
+        row.valueIsString = false;
+      }
+      return true;
+    }
+};
+
+/*
+  Inserts each row from WelshStatsSAXHandler that passed the filters into an
+  Areas instance, converting its value only then.
+*/
+class WelshStatsRowInserter {
+  public:
+    WelshStatsRowInserter(
+        Areas& areas,
+        const BethYw::SourceColumnMapping &cols,
+        ImportCounts& counts)
+        : areas(areas), counts(counts) {
+      // checking if the which format of names and codes we are using
+      usingSingles = cols.count(BethYw::MEASURE_CODE) == 0;
+
+      required = WelshStatsSAXHandler::SLOT_AUTH_CODE |
+                 WelshStatsSAXHandler::SLOT_AUTH_NAME_ENG |
+                 WelshStatsSAXHandler::SLOT_YEAR |
+                 WelshStatsSAXHandler::SLOT_VALUE;
+      if(usingSingles){
+        singleMeasureCode = cols.at(BethYw::SINGLE_MEASURE_CODE);
+        singleMeasureLabel = cols.at(BethYw::SINGLE_MEASURE_NAME);
+        transform(singleMeasureCode.begin(), singleMeasureCode.end(),
+                  singleMeasureCode.begin(), ::tolower);
+      }else{
+        required |= WelshStatsSAXHandler::SLOT_MEASURE_CODE |
+                    WelshStatsSAXHandler::SLOT_MEASURE_NAME;
+      }
+    }
+
+    void operator()(const WelshStatsRow& row) {
+      if((row.seen & required) != required){
+        throw std::runtime_error(
+            "Areas::populateFromWelshStatsJSON: Row is missing a column");
+      }
+      counts.rowsParsed++;
+      if(row.rejected){
+        counts.rowsFiltered++;
+        return;
+      }
+
+      //measures, the value in the json may be a string or number
+      double measureData = row.valueIsString ? std::stod(row.valueString)
+                                             : row.value;
+      const Symbol measureCode = symbols.get(usingSingles ? singleMeasureCode
+                                                          : row.measureCode);
+      const Symbol measureLabel = symbols.get(usingSingles ? singleMeasureLabel
+                                                           : row.measureName);
+
+      Area& area = areas.findOrCreateArea(symbols.get(row.authCode));
+      // a newly created area has no names yet
+      if(area.getNamesView().empty()){
+        area.setName("eng", row.authNameEng);
+      }
+      area.upsertValue(measureCode, measureLabel, row.year, measureData);
+    }
+
+  private:
+    Areas& areas;
+    ImportCounts& counts;
+    // one per inserter, so each chunk parsed on its own thread has its own
+    SymbolCache symbols;
+    bool usingSingles;
+    unsigned int required;
+    std::string singleMeasureCode;
+    std::string singleMeasureLabel;
+};
+
+/*
+  Finds the text of every row in the top-level "value" arrays of a StatsWales
+  JSON document without parsing the rows themselves, so that the rows can be
+  split between threads. Strings are skipped over (including any brackets or
+  commas inside them) and brackets are checked to be balanced.
+
+  Returns false if the document is not a well-formed JSON object as far as the
+  scan can tell, in which case it should be parsed in one go so that the
+  error is reported in the usual way.
+*/
+bool findWelshStatsRows(std::string_view data,
+                        std::vector<std::string_view>& rows){
+  auto isSpace = [](char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+  };
+  auto skipSpace = [&](std::size_t i) {
+    while(i < data.size() && isSpace(data[i])){
+      i++;
+    }
+    return i;
+  };
+  // trims whitespace and adds a row, failing on an empty array element
+  auto addRow = [&](std::size_t start, std::size_t end) {
+    while(start < end && isSpace(data[start])) start++;
+    while(end > start && isSpace(data[end - 1])) end--;
+    if(start == end){
+      return false;
+    }
+    rows.push_back(data.substr(start, end - start));
+    return true;
+  };
+
+  std::size_t i = skipSpace(0);
+  if(i >= data.size() || data[i] != '{'){
+    return false;
+  }
+
+  std::string brackets;
+  bool nextIsValueArray = false;
+  bool inValueArray = false;
+  std::size_t rowStart = 0;
+  std::size_t valueArrayStart = 0;
+  while(i < data.size()){
+    const char c = data[i];
+    if(c == '"'){
+      const std::size_t start = ++i;
+      while(i < data.size() && data[i] != '"'){
+        i += data[i] == '\\' ? 2 : 1;
+      }
+      if(i >= data.size()){
+        return false;
+      }
+      const std::string_view str = data.substr(start, i - start);
+      i = skipSpace(i + 1);
+      // a string followed by a colon in the top-level object is a key
+      if(brackets.size() == 1 && i < data.size() && data[i] == ':'){
+        nextIsValueArray = str == "value";
+        i++;
+      }else if(brackets.size() == 1){
+        nextIsValueArray = false;
+      }
+      continue;
+    }
+
+    if(c == '{' || c == '['){
+      if(c == '[' && brackets.size() == 1 && nextIsValueArray){
+        inValueArray = true;
+        rowStart = i + 1;
+        valueArrayStart = rowStart;
+      }
+      if(brackets.size() == 1){
+        nextIsValueArray = false;
+      }
+      brackets += c;
+    }else if(c == '}' || c == ']'){
+      if(brackets.empty() || brackets.back() != (c == '}' ? '{' : '[')){
+        return false;
+      }
+      if(inValueArray && brackets.size() == 2){
+        inValueArray = false;
+        // an empty array has no rows, but "[{...},]" is malformed
+        if(!addRow(rowStart, i) && rowStart != valueArrayStart){
+          return false;
+        }
+      }
+      brackets.pop_back();
+      if(brackets.empty()){
+        break;
+      }
+    }else if(c == ',' && inValueArray && brackets.size() == 2){
+      if(!addRow(rowStart, i)){
+        return false;
+      }
+      rowStart = i + 1;
+    }
+    i++;
+  }
+
+  return brackets.empty() && skipSpace(i + 1) >= data.size();
+}
+
+} // namespace
+
 /*
   TODO: Areas::populateFromWelshStatsJSON(is,
                                           cols,
@@ -285,6 +1176,17 @@ void Areas::populateFromAuthorityCodeCSV(
   If you encounter an Area that does not exist in the Areas container, you
   should create the Area object
 
+  The file is read as a stream of SAX events (see WelshStatsSAXHandler above)
+  rather than into a json DOM, so each row is filtered and inserted as soon as
+  it has been read and memory use does not grow with the size of the file.
+
+  When the file is already in memory, it can also be parsed on several
+  threads. The rows of the "value" array are found with a quick scan of the
+  text and split into one run of consecutive rows per thread. Each thread
+  parses its rows into its own Areas, and these are merged into this instance
+  in row order (see Areas::merge()), so the result is the same as parsing the
+  rows one after another.
+
   If areasFilter is a non-empty set only include areas matching the filter. If
   measuresFilter is a non-empty set only include measures matching the filter.
   If yearsFilter is not equal to <0,0>, only import years within the range
@@ -318,11 +1220,23 @@ void Areas::populateFromAuthorityCodeCSV(
     where if both values are 0, then all years should be imported, otherwise
     they should be treated as the range of years to be imported (inclusively)
 
+  @param filter
+    The three filters compiled into a FilterSpec, for the overloads that take
+    one instead (see filter.h)
+
+  @param data
+    The contents of the file, for the overload that parses data in memory
+
+  @param threads
+    The number of threads to parse data with, which defaults to 1
+
   @return
     void
 
   @throws 
-    std::runtime_error if a parsing error occurs (e.g. due to a malformed file)
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file,
+    or a year given as a number that is not a whole number within the range
+    of int)
     std::out_of_range if there are not enough columns in cols
 
   @see
@@ -356,86 +1270,86 @@ void Areas::populateFromWelshStatsJSON(
     const StringFilterSet * const areasFilter,
     const StringFilterSet * const measuresFilter,
     const YearFilterTuple * const yearsFilter){
-      // checking if the which format of names and codes we are using
-      bool usingSingles = true;
-      if(cols.count(BethYw::MEASURE_CODE)>0){
-        usingSingles = false;
-      }
-      json j;
-      is >> j;
-      for (auto& el : j["value"].items()) {
+      populateFromWelshStatsJSON(
+          is, cols, FilterSpec(areasFilter, measuresFilter, yearsFilter));
+}
 
-        if(el.value() == NULL){
-          continue;
-        }
-        auto &data = el.value();
-        std::string localAuthorityCode = data[cols.at(BethYw::AUTH_CODE)];
-        std::string localAuthorityNameEng = data[cols.at(BethYw::AUTH_NAME_ENG)];
-        unsigned int startFilterYearUS = std::get<0>(*yearsFilter);
-        unsigned int endFilterYearUS = std::get<1>(*yearsFilter);
-
-        int startFilterYear = (int) startFilterYearUS;
-        int endFilterYear = (int) endFilterYearUS;
-
-
-        //measures, we need to check if the value in the json is a string or number
-        auto measureDataJSON = data[cols.at(BethYw::VALUE)];
-        double measureData;
-        std::string measureDataString;
-        if(measureDataJSON.is_string()){
-          measureDataString = data[cols.at(BethYw::VALUE)];
-          measureData = std::stod(measureDataString);
-        }else{
-          measureData = data[cols.at(BethYw::VALUE)];
-        }
+void Areas::populateFromWelshStatsJSON(
+    std::istream &is,
+    const BethYw::SourceColumnMapping &cols,
+    const FilterSpec &filter){
+      BETHYW_TRACE_SCOPE("Areas::populateFromWelshStatsJSON");
+      WelshStatsSAXHandler handler(cols, filter,
+                                   WelshStatsRowInserter(*this, cols,
+                                                         importCounts));
+      json::sax_parse(is, &handler);
+}
 
-        std::string measureCode;
-        std::string measureLabel;
-        if(usingSingles){
-          measureCode = cols.at(BethYw::SINGLE_MEASURE_CODE);
-          measureLabel = cols.at(BethYw::SINGLE_MEASURE_NAME);
-        }else{
-          measureCode = data[cols.at(BethYw::MEASURE_CODE)];
-          measureLabel = data[cols.at(BethYw::MEASURE_NAME)];
-        }
+void Areas::populateFromWelshStatsJSON(
+    std::string_view data,
+    const BethYw::SourceColumnMapping &cols,
+    const StringFilterSet * const areasFilter,
+    const StringFilterSet * const measuresFilter,
+    const YearFilterTuple * const yearsFilter,
+    unsigned int threads){
+  populateFromWelshStatsJSON(
+      data, cols, FilterSpec(areasFilter, measuresFilter, yearsFilter), threads);
+}
+
+void Areas::populateFromWelshStatsJSON(
+    std::string_view data,
+    const BethYw::SourceColumnMapping &cols,
+    const FilterSpec &filter,
+    unsigned int threads){
+  BETHYW_TRACE_SCOPE("Areas::populateFromWelshStatsJSON");
+  std::vector<std::string_view> rows;
+  if(threads <= 1 || !findWelshStatsRows(data, rows) || rows.size() < 2){
+    WelshStatsSAXHandler handler(cols, filter,
+                                 WelshStatsRowInserter(*this, cols,
+                                                       importCounts));
+    json::sax_parse(data.begin(), data.end(), &handler);
+    return;
+  }
 
-        std::string measureYear = data[cols.at(BethYw::YEAR)];
-        int convertMeasureYear = stoi(measureYear);
+  // Split the rows into one run of consecutive rows per thread, of roughly
+  // equal size in bytes
+  const std::size_t chunks = std::min<std::size_t>(threads, rows.size());
+  const std::size_t bytesPerChunk =
+      (rows.back().end() - rows.front().begin()) / chunks + 1;
+  std::vector<std::size_t> chunkStarts{0};
+  for(std::size_t i = 1; i < rows.size() && chunkStarts.size() < chunks; i++){
+    if(static_cast<std::size_t>(rows[i].begin() - rows[chunkStarts.back()].begin())
+       >= bytesPerChunk){
+      chunkStarts.push_back(i);
+    }
+  }
+  chunkStarts.push_back(rows.size());
+
+  // Each thread parses its rows into its own Areas, one row at a time. These
+  // only live until they are merged, so their arenas are freed straight away
+  auto parseChunk = [&](std::size_t first, std::size_t last) {
+    BETHYW_TRACE_SCOPE("Areas::populateFromWelshStatsJSON/chunk");
+    Areas partial(Areas::Arena);
+    WelshStatsSAXHandler handler(cols, filter,
+                                 WelshStatsRowInserter(partial, cols,
+                                                       partial.importCounts),
+                                 true);
+    for(std::size_t i = first; i < last; i++){
+      json::sax_parse(rows[i].begin(), rows[i].end(), &handler);
+    }
+    return partial;
+  };
 
-        transform(measureCode.begin(), measureCode.end(), measureCode.begin(), ::tolower);
-        std::unordered_set<std::string>::const_iterator got = areasFilter->find (localAuthorityCode);
-        std::unordered_set<std::string>::const_iterator gotM = measuresFilter->find (measureCode);
-        // checking the filters 
-        if(got == areasFilter->end() && !areasFilter->empty()){
-          continue;
-        }
-        if(gotM == measuresFilter->end() && !measuresFilter->empty()){
-          continue;
-        }
-        if(convertMeasureYear < startFilterYear || convertMeasureYear > endFilterYear){
-          if(startFilterYear != 0 || endFilterYear != 0){
-            continue;
-          }
-        }
-        // if area doenst exist yet
-        if(areasContainer.count(localAuthorityCode) == 0){
-          Area area(localAuthorityCode);
-          area.setName("eng", localAuthorityNameEng);
-          setArea(localAuthorityCode, area);
-         }
-        Area& area = getArea(localAuthorityCode);
-        // if measure doesnt exist for area
-        if(!area.checkMeasure(measureCode)){
-          Measure measure(measureCode, measureLabel);
-          measure.setValue(convertMeasureYear, measureData);
-          area.setMeasure(measureCode, measure);
-        }else{
-          auto measure = area.getMeasure(measureCode);
-          measure.setValue(convertMeasureYear, measureData);
-          area.setMeasure(measureCode, measure);
-        }
+  std::vector<std::future<Areas>> partials;
+  for(std::size_t i = 0; i + 1 < chunkStarts.size(); i++){
+    partials.push_back(std::async(std::launch::async, parseChunk,
+                                  chunkStarts[i], chunkStarts[i + 1]));
   }
 
+  // Merging in row order gives the same result as parsing the rows in turn
+  for(auto& partial : partials){
+    merge(partial.get());
+  }
 }
 
 
@@ -455,6 +1369,10 @@ void Areas::populateFromWelshStatsJSON(
   have to rely on the names already populated through 
   Areas::populateFromAuthorityCodeCSV();
 
+  As with areas.csv, rows are read one at a time with CSVReader. Empty cells
+  are treated as missing values, and an Area is only created for a row once
+  one of its values passes the filters.
+
   The datasets that will be parsed by this function are
    - complete-popu1009-area.csv
    - complete-popu1009-pop.csv
@@ -511,39 +1429,82 @@ void Areas::populateFromAuthorityByYearCSV(
   const StringFilterSet * const areasFilter,
   const StringFilterSet * const measuresFilter,
   const YearFilterTuple * const yearsFilter){
-    // reading the csv into a stringstream, to put commas at the new lines
-    // then reading the stringstream into a vector using the commas as delimiters
-    std::string line;
-    std::vector<std::string> result;
-    //this is a container of the years 
+    CSVReader reader(is);
+    populateFromAuthorityByYearCSV(
+        reader, cols, FilterSpec(areasFilter, measuresFilter, yearsFilter));
+}
+
+void Areas::populateFromAuthorityByYearCSV(
+  CSVReader &reader,
+  const BethYw::SourceColumnMapping &cols,
+  const FilterSpec &filter){
+    BETHYW_TRACE_SCOPE("Areas::populateFromAuthorityByYearCSV");
+    const std::string& measureLabel = cols.at(BethYw::SINGLE_MEASURE_NAME);
+    std::string measureCode = cols.at(BethYw::SINGLE_MEASURE_CODE);
+    transform(measureCode.begin(), measureCode.end(), measureCode.begin(), ::tolower);
+
+    if(!reader.nextRow()){
+      throw std::runtime_error(
+          "Areas::populateFromAuthorityByYearCSV: File has no header row");
+    }
+    // the header is the authority code column followed by one column per year
+    const auto& header = reader.fields();
+    if(header.empty() || header[0] != cols.at(BethYw::AUTH_CODE)){
+      throw std::runtime_error(
+          "Areas::populateFromAuthorityByYearCSV: Missing column "
+          + cols.at(BethYw::AUTH_CODE));
+    }
+    // each year column is checked against the year filter once, here
     std::vector<int> columnHeaders;
-    bool pastFirstText = false;
-    bool pastColumnHeaders = false;
-    while(getline(is, line)){
-      std::stringstream ss(line);
-      while(getline(ss, line,',')){
-        result.push_back(line);
-        
-        // this for getting the column headers and ignoring the 0th element
-        if(!pastFirstText){
-          pastFirstText = true;
-        }else if(isdigit(line[0]) && pastFirstText && !pastColumnHeaders){
-          columnHeaders.push_back(std::stoi(line));
-        }else if(!isdigit(line[0]) && pastFirstText){
-          pastColumnHeaders = true;
+    std::vector<char> columnAccepted;
+    for(std::size_t i = 1; i < header.size(); i++){
+      columnHeaders.push_back(parseCSVNumber<int>(header[i], 1));
+      columnAccepted.push_back(filter.acceptsYear(columnHeaders.back()));
+    }
+    const std::size_t columns = header.size();
+    // if the measure is filtered out, the rows are still read so that they
+    // are counted, but none of their values are converted
+    const bool measureAccepted = filter.acceptsMeasure(measureCode);
+
+    SymbolCache symbols;
+    const Symbol measureSymbol = symbols.get(measureCode);
+    const Symbol labelSymbol = symbols.get(measureLabel);
+    while(reader.nextRow()){
+      const auto& fields = reader.fields();
+      if(fields.size() != columns){
+        throw std::runtime_error(
+            "Areas::populateFromAuthorityByYearCSV: Wrong number of columns "
+            "on row " + std::to_string(reader.getRowNumber()));
+      }
+      importCounts.rowsParsed++;
+      if(!measureAccepted || !filter.acceptsArea(fields[0])){
+        importCounts.rowsFiltered++;
+        continue;
+      }
+      // the area is only created once it has a value to hold
+      Area* area = nullptr;
+      bool yearFiltered = false;
+      for(std::size_t i = 1; i < columns; i++){
+        if(fields[i].empty()){
+          continue;
         }
+        if(!columnAccepted[i - 1]){
+          yearFiltered = true;
+          continue;
+        }
+        const int year = columnHeaders[i - 1];
+        const double value =
+            parseCSVNumber<double>(fields[i], reader.getRowNumber());
+        if(area == nullptr){
+          area = &findOrCreateArea(symbols.get(fields[0]));
+        }
+        area->upsertValue(measureSymbol, labelSymbol, year, value);
       }
-    }   
-      int sizeOfResult = static_cast<int>(result.size());
-      // i just copied this from the populate function above. I ran out of time
-      for(int i =3;i<sizeOfResult-2;i=i+3){
-        auto localAuthorityCode = result.at(i);
-        Area area(localAuthorityCode);
-        area.setName("eng", result.at(i+1));
-        area.setName("cym", result.at(i+2));
-        setArea(localAuthorityCode, area);
+      // a row with values only in years that are filtered out is filtered
+      if(area == nullptr && yearFiltered){
+        importCounts.rowsFiltered++;
       }
-      std::cout<<this->size();
+    }
 }
 
 
@@ -699,14 +1660,150 @@ void Areas::populate(
     const StringFilterSet * const measuresFilter,
     const YearFilterTuple * const yearsFilter)
      {
+  populate(is, type, cols, FilterSpec(areasFilter, measuresFilter, yearsFilter));
+}
+
+/*
+  Areas::populate(is, type, cols, filter)
+  Areas::populate(data, type, cols, filter, threads)
+
+  The same as the populate() functions that take pointers to the filters,
+  but with the filters already compiled into a FilterSpec, so that one can be
+  built once and shared by every dataset imported.
+
+  @param filter
+    The areas, measures and years to import
+
+  @example
+    FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+
+    Areas data = Areas();
+    for(const auto& dataset : datasetsToImport){
+      MappedInputFile input(dir + dataset.FILE);
+      data.populate(input.open(), dataset.PARSER, dataset.COLS, filter);
+    }
+*/
+void Areas::populate(
+    std::istream &is,
+    const BethYw::SourceDataType &type,
+    const BethYw::SourceColumnMapping &cols,
+    const FilterSpec &filter) {
+  if(type == BethYw::WelshStatsJSON){
+    populateFromWelshStatsJSON(is, cols, filter);
+    return;
+  }
+
+  CSVReader reader(is);
   if (type == BethYw::AuthorityByYearCSV) {
-    populateFromAuthorityByYearCSV(is, cols, areasFilter,
-                              measuresFilter,yearsFilter);
-  }else if(type == BethYw::WelshStatsJSON){
-    populateFromWelshStatsJSON(is,cols,areasFilter,
-                              measuresFilter,yearsFilter);
+    populateFromAuthorityByYearCSV(reader, cols, filter);
   }else if(type == BethYw::AuthorityCodeCSV){
-    populateFromAuthorityCodeCSV(is, cols);
+    populateFromAuthorityCodeCSV(reader, cols, filter);
+  }else{
+    throw std::runtime_error("Areas::populate: Unexpected data type");
+  }
+}
+
+/*
+  Areas::populate(data, type, cols)
+  Areas::populate(data, type, cols, areasFilter, measuresFilter, yearsFilter)
+
+  The same as the stream-based populate() functions above, but parsing data
+  that is already in memory, such as the view returned by
+  MappedInputFile::open(). Both JSON and CSV are parsed directly from the
+  bytes in data without copying them.
+
+  @param data
+    The contents of the input source
+
+  @param type
+    A value from the BethYw::SourceDataType enum which states the underlying
+    data file structure
+
+  @param cols
+    A map of the enum BethyYw::SourceColumnMapping (see datasets.h) to strings
+    that give the column header in the CSV file
+
+  @param areasFilter
+    An umodifiable pointer to set of umodifiable strings for areas to import,
+    or an empty set if all areas should be imported
+
+  @param measuresFilter
+    An umodifiable pointer to set of umodifiable strings for measures to import,
+    or an empty set if all measures should be imported
+
+  @param yearsFilter
+    An umodifiable pointer to an umodifiable tuple of two unsigned integers,
+    where if both values are 0, then all years should be imported, otherwise
+    they should be treated as a the range of years to be imported
+
+  @param threads
+    The number of threads to parse a WelshStatsJSON file with, see
+    populateFromWelshStatsJSON(). CSV files are always parsed on one thread.
+
+  @return
+    void
+
+  @throws
+    std::runtime_error if a parsing error occurs (e.g. due to a malformed file),
+    data is empty, or an unexpected type is passed in.
+    std::out_of_range if there are not enough columns in cols
+
+  @example
+    MappedInputFile input("data/popu1009.json");
+    auto data = input.open();
+
+    auto cols = InputFiles::DATASETS["popden"].COLS;
+
+    Areas data = Areas();
+    areas.populate(
+      data,
+      DataType::WelshStatsJSON,
+      cols,
+      &areasFilter,
+      &measuresFilter,
+      &yearsFilter);
+*/
+void Areas::populate(std::string_view data,
+                     const BethYw::SourceDataType &type,
+                     const BethYw::SourceColumnMapping &cols) {
+  if(type == BethYw::AuthorityCodeCSV){
+    populate(data, type, cols, nullptr, nullptr, nullptr);
+  }else{
+    throw std::runtime_error("Areas::populate: Unexpected data type");
+  }
+}
+
+void Areas::populate(
+    std::string_view data,
+    const BethYw::SourceDataType &type,
+    const BethYw::SourceColumnMapping &cols,
+    const StringFilterSet * const areasFilter,
+    const StringFilterSet * const measuresFilter,
+    const YearFilterTuple * const yearsFilter,
+    unsigned int threads) {
+  populate(data, type, cols,
+           FilterSpec(areasFilter, measuresFilter, yearsFilter), threads);
+}
+
+void Areas::populate(
+    std::string_view data,
+    const BethYw::SourceDataType &type,
+    const BethYw::SourceColumnMapping &cols,
+    const FilterSpec &filter,
+    unsigned int threads) {
+  if(data.empty()){
+    throw std::runtime_error("Areas::populate: Input source is empty");
+  }
+  if(type == BethYw::WelshStatsJSON){
+    populateFromWelshStatsJSON(data, cols, filter, threads);
+    return;
+  }
+
+  CSVReader reader(data);
+  if(type == BethYw::AuthorityByYearCSV){
+    populateFromAuthorityByYearCSV(reader, cols, filter);
+  }else if(type == BethYw::AuthorityCodeCSV){
+    populateFromAuthorityCodeCSV(reader, cols, filter);
   }else {
     throw std::runtime_error("Areas::populate: Unexpected data type");
   }
@@ -768,6 +1865,9 @@ void Areas::populate(
 
   An empty JSON is "{}" (without the quotes), which you must return if your
   Areas object is empty.
+
+  The JSON is built by writeJSON() below rather than as a json object, so no
+  copy of the data is made other than the returned string itself.
   
   @return
     std::string of JSON
@@ -786,8 +1886,191 @@ void Areas::populate(
     std::cout << data.toJSON();
 */
 std::string Areas::toJSON() const {
-  json j;
-  return j.dump();
+  std::ostringstream os;
+  writeJSON(os);
+  return os.str();
+}
+
+namespace {
+
+// Appends a string to a JSON document in quotes, escaping it in the same way
+// as json::dump(). Non-ASCII characters are written as they are.
+void appendJSONString(std::string& out, std::string_view str) {
+  static const char hex[] = "0123456789abcdef";
+  out += '"';
+  for(unsigned char c : str){
+    switch(c){
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\b': out += "\\b"; break;
+      case '\f': out += "\\f"; break;
+      case '\n': out += "\\n"; break;
+      case '\r': out += "\\r"; break;
+      case '\t': out += "\\t"; break;
+      default:
+        if(c < 0x20){
+          out += "\\u00";
+          out += hex[c >> 4];
+          out += hex[c & 0xf];
+        }else{
+          out += static_cast<char>(c);
+        }
+    }
+  }
+  out += '"';
+}
+
+// Appends a number to a JSON document in the shortest form that reads back
+// as the same double, laid out as json::dump() lays it out: numbers from
+// 1e-4 up to 1e15 in size in decimal notation with at least one digit after
+// the point (e.g. 711.6801 and -999.0), and others as e.g. 1.5e+16 or 1e-05
+void appendJSONNumber(std::string& out, double value) {
+  if(!std::isfinite(value)){
+    out += "null";
+    return;
+  }
+  // the shortest digits that read back as value, as [-]d[.ddd]e<+|->xx
+  char buffer[32];
+  const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                                    std::chars_format::scientific);
+  std::string_view number(buffer, result.ptr - buffer);
+  if(number[0] == '-'){
+    out += '-';
+    number.remove_prefix(1);
+  }
+  const std::size_t e = number.find('e');
+  int exponent = 0;
+  std::from_chars(number.data() + e + (number[e + 1] == '+' ? 2 : 1),
+                  number.data() + number.size(), exponent);
+
+  char digits[32];
+  int size = 0;
+  for(char c : number.substr(0, e)){
+    if(c != '.'){
+      digits[size++] = c;
+    }
+  }
+  // the point comes after the first point digits
+  const int point = exponent + 1;
+  if(size <= point && point <= 15){
+    out.append(digits, size);
+    out.append(point - size, '0');
+    out += ".0";
+  }else if(0 < point && point <= 15){
+    out.append(digits, point);
+    out += '.';
+    out.append(digits + point, size - point);
+  }else if(-4 < point && point <= 0){
+    out += "0.";
+    out.append(-point, '0');
+    out.append(digits, size);
+  }else{
+    out += number;
+  }
+}
+
+// Appends the years and values of a Measure as a JSON object. json::dump()
+// orders the years as strings, which is only different from numeric order
+// when the years have different numbers of digits.
+void appendJSONValues(std::string& out, const Measure& measure) {
+  std::vector<std::pair<std::string, double>> values;
+  values.reserve(measure.size());
+  for(const auto& value : measure){
+    values.emplace_back(std::to_string(value.first), value.second);
+  }
+  if(values.front().first.size() != values.back().first.size() ||
+     values.front().first[0] == '-'){
+    std::sort(values.begin(), values.end());
+  }
+
+  out += '{';
+  for(std::size_t i = 0; i < values.size(); i++){
+    if(i > 0){
+      out += ',';
+    }
+    out += '"';
+    out += values[i].first;
+    out += "\":";
+    appendJSONNumber(out, values[i].second);
+  }
+  out += '}';
+}
+
+} // namespace
+
+/*
+  Areas::writeJSON(os)
+
+  Write this Areas object as JSON straight to an output stream, in the format
+  described for toJSON() above and byte for byte the same as json::dump()
+  would give, but without building a json object first. Each Area is written
+  as soon as it has been formatted, so memory use does not grow with the
+  number of areas.
+
+  Keys are in sorted order, as json::dump() gives, so "measures" comes before
+  "names". An Area with no values has no "measures" key, and a Measure with
+  no values is left out.
+
+  Values are written with std::to_chars() in the shortest form that reads
+  back as the same double. json::dump() does not always find the shortest
+  form, so for a few values with 16 or 17 significant digits it writes
+  different final digits; both read back as the same double.
+
+  @param os
+    The output stream to write to
+
+  @example
+    Areas data = Areas();
+    ...
+    data.writeJSON(std::cout);
+*/
+void Areas::writeJSON(std::ostream &os) const {
+  BETHYW_TRACE_SCOPE("Areas::writeJSON");
+  std::string out;
+  out += '{';
+  bool firstArea = true;
+  for(const auto& area : getAreasView()){
+    if(!firstArea){
+      out += ',';
+    }
+    firstArea = false;
+
+    appendJSONString(out, area.first);
+    out += ":{";
+
+    bool firstMeasure = true;
+    for(const auto& measure : area.second.getMeasuresView()){
+      if(measure.second.size() == 0){
+        continue;
+      }
+      out += firstMeasure ? "\"measures\":{" : ",";
+      firstMeasure = false;
+      appendJSONString(out, measure.first);
+      out += ':';
+      appendJSONValues(out, measure.second);
+    }
+    if(!firstMeasure){
+      out += "},";
+    }
+
+    out += "\"names\":{";
+    bool firstName = true;
+    for(const auto& name : area.second.getNamesView()){
+      if(!firstName){
+        out += ',';
+      }
+      firstName = false;
+      appendJSONString(out, name.first);
+      out += ':';
+      appendJSONString(out, name.second);
+    }
+    out += "}}";
+
+    os.write(out.data(), out.size());
+    out.clear();
+  }
+  out += '}';
+  os.write(out.data(), out.size());
 }
 
 /*
@@ -896,9 +2179,9 @@ std::string Areas::toJSON() const {
     Areas areas();
     std::cout << areas << std::end;
 */
-std::ostream& operator<<(std::ostream &os, Areas areas){
-  auto Allareas = areas.getAllAreas();
-  for(const auto& x: Allareas){
+std::ostream& operator<<(std::ostream &os, const Areas& areas){
+  BETHYW_TRACE_SCOPE("operator<<(Areas)");
+  for(const auto& x: areas.getAreasView()){
     os<<x.second;
   }
   return os;
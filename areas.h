@@ -26,33 +26,124 @@
   functions and member variables you need to declare in this class.
  */
 
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 #include "datasets.h"
 #include "area.h"
+#include "filter.h"
 
-/*
-  An alias for filters based on strings such as categorisations e.g. area,
-  and measures.
-*/
-using StringFilterSet = std::unordered_set<std::string>;
+class CSVReader;
 
 /*
-  An alias for a year filter.
-*/
-using YearFilterTuple = std::tuple<unsigned int, unsigned int>;
+  An alias for the data within an Areas object stores Area objects, keyed by
+  their interned local authority codes. It is a std::pmr container so that
+  the Areas, and everything inside them, can come from an arena.
 
-/*
-  An alias for the data within an Areas object stores Area objects.
+  It is a hash table: a Symbol hashes by its address, so finding an Area is a
+  single probe with no string comparisons. Anything that needs the Areas in
+  order of local authority code uses an AreasView instead.
 
   TODO: you should remove the declaration of the Null class below, and set
   AreasContainer to a valid Standard Library container of your choosing.
 */
 //class Null { };
-using AreasContainer = std::map<std::string, Area>;
+using AreasContainer = std::pmr::unordered_map<Symbol, Area>;
+
+/*
+  A read-only view of the Areas in an AreasContainer in order of local
+  authority code, as returned by Areas::getAreasView(). It is a sorted list of
+  pointers to the entries, and iterating over it gives the entries themselves.
+*/
+class AreasView {
+  public:
+    using value_type = AreasContainer::value_type;
+    using Entries = std::vector<const value_type*>;
+
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = AreasView::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator(Entries::const_iterator it) : it(it) {}
+
+        reference operator*() const {
+          return **it;
+        }
+
+        pointer operator->() const {
+          return *it;
+        }
+
+        const_iterator& operator++() {
+          ++it;
+          return *this;
+        }
+
+        const_iterator operator++(int) {
+          const_iterator previous = *this;
+          ++it;
+          return previous;
+        }
+
+        bool operator==(const const_iterator& other) const {
+          return it == other.it;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+          return it != other.it;
+        }
+
+      private:
+        Entries::const_iterator it;
+    };
+
+    AreasView(const Entries& entries) : entries(&entries) {}
+
+    const_iterator begin() const {
+      return const_iterator(entries->begin());
+    }
+
+    const_iterator end() const {
+      return const_iterator(entries->end());
+    }
+
+    std::size_t size() const noexcept {
+      return entries->size();
+    }
+
+    bool empty() const noexcept {
+      return entries->empty();
+    }
+
+    friend bool operator==(const AreasView& lhs, const AreasView& rhs);
+
+  private:
+    const Entries* entries;
+};
+
+/*
+  The number of rows read by the populate functions of an Areas instance, for
+  the --stats argument. A row is filtered if it was read but nothing from it
+  was kept because of the filters.
+*/
+struct ImportCounts {
+  std::uint64_t rowsParsed = 0;
+  std::uint64_t rowsFiltered = 0;
+};
 
 /*
   Areas is a class that stores all the data categorised by area. The 
@@ -64,22 +155,80 @@ using AreasContainer = std::map<std::string, Area>;
   specific parsing of code to other functions, based on the value of 
   BethYw::SourceDataType.
 
+  An Areas instance constructed with Areas::Arena owns a monotonic arena, from
+  which every Area, Measure, map node and value buffer inside it is
+  allocated. Nothing is freed until the Areas instance is destroyed, when the
+  arena is released in bulk, which suits a short-lived batch run better than
+  freeing each node in turn. Areas constructed normally use the heap.
+
+  An Areas instance can also allocate from another's arena (see
+  getResource()), so that merging it into that Areas instance moves its nodes
+  across rather than copying them. It must then be destroyed first, and both
+  must only be used from one thread at a time, as the arena is not
+  synchronised.
+
   TODO: Based on your implementation, there may be additional constructors
   or functions you implement here, and perhaps additional operators you may wish
   to overload.
 */
 class Areas {
 private:
+  // declared before the container, so the arena outlives everything in it
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
   AreasContainer areasContainer;
+
+  // the AreasView, rebuilt by getAreasView() after an Area is added
+  mutable AreasView::Entries sortedAreas;
+  mutable std::atomic<bool> sortedAreasValid{false};
+  mutable std::mutex sortedAreasMutex;
+
+  ImportCounts importCounts;
+
+  AreasContainer::iterator findArea(std::string_view localAuthorityCode);
+  AreasContainer::const_iterator findArea(
+      std::string_view localAuthorityCode) const;
+
+  void populateFromAuthorityCodeCSV(
+      CSVReader& reader,
+      const BethYw::SourceColumnMapping& cols,
+      const FilterSpec& filter);
+
+  void populateFromAuthorityByYearCSV(
+      CSVReader& reader,
+      const BethYw::SourceColumnMapping& cols,
+      const FilterSpec& filter);
 public:
+  enum Allocation { Heap, Arena };
+
   Areas();
+  explicit Areas(Allocation allocation);
+  explicit Areas(std::pmr::memory_resource* resource);
+  Areas(const Areas& other);
+  Areas(Areas&& other) noexcept;
+  Areas& operator=(const Areas& other);
+  Areas& operator=(Areas&& other);
+  bool usesArena() const noexcept;
+  std::pmr::memory_resource* getResource() const noexcept;
+  void setArea(
+      std::string localAuthorityCode,
+      const Area& area);
   void setArea(
-      std::string localAuthorityCode, 
-      Area area);
+      std::string localAuthorityCode,
+      Area&& area);
+  void merge(Areas&& other);
+  Areas select(const FilterSpec& filter) const;
+  Area& findOrCreateArea(
+      Symbol localAuthorityCode);
   Area& getArea(
       std::string localAuthorityCode);
-  std::map<std::string, Area> getAllAreas();
-  int size();
+  const Area& getArea(
+      std::string localAuthorityCode) const;
+  std::map<std::string, Area> getAllAreas() const;
+  AreasView getAreasView() const;
+  int size() const;
+  const ImportCounts& getImportCounts() const noexcept;
+  Measure getMeasureTotals(std::string codename) const;
+  Stats::Summary getMeasureSummary(std::string codename) const;
   void populateFromAuthorityCodeCSV(
       std::istream& is,
       const BethYw::SourceColumnMapping& cols,
@@ -92,7 +241,26 @@ public:
       const StringFilterSet * const areasFilter,
       const StringFilterSet * const measuresFilter,
       const YearFilterTuple * const yearsFilter);
-    
+
+  void populateFromWelshStatsJSON(
+      std::string_view data,
+      const BethYw::SourceColumnMapping &cols,
+      const StringFilterSet * const areasFilter,
+      const StringFilterSet * const measuresFilter,
+      const YearFilterTuple * const yearsFilter,
+      unsigned int threads = 1);
+
+  void populateFromWelshStatsJSON(
+      std::istream &is,
+      const BethYw::SourceColumnMapping &cols,
+      const FilterSpec &filter);
+
+  void populateFromWelshStatsJSON(
+      std::string_view data,
+      const BethYw::SourceColumnMapping &cols,
+      const FilterSpec &filter,
+      unsigned int threads = 1);
+
   void populateFromAuthorityByYearCSV(
       std::istream &is, 
       const BethYw::SourceColumnMapping &cols, 
@@ -113,8 +281,39 @@ public:
       const YearFilterTuple * const yearsFilter)
       noexcept(false);
 
+  void populate(
+      std::string_view data,
+      const BethYw::SourceDataType& type,
+      const BethYw::SourceColumnMapping& cols) noexcept(false);
+
+  void populate(
+      std::string_view data,
+      const BethYw::SourceDataType& type,
+      const BethYw::SourceColumnMapping& cols,
+      const StringFilterSet * const areasFilter,
+      const StringFilterSet * const measuresFilter,
+      const YearFilterTuple * const yearsFilter,
+      unsigned int threads = 1)
+      noexcept(false);
+
+  void populate(
+      std::istream& is,
+      const BethYw::SourceDataType& type,
+      const BethYw::SourceColumnMapping& cols,
+      const FilterSpec& filter)
+      noexcept(false);
+
+  void populate(
+      std::string_view data,
+      const BethYw::SourceDataType& type,
+      const BethYw::SourceColumnMapping& cols,
+      const FilterSpec& filter,
+      unsigned int threads = 1)
+      noexcept(false);
+
   std::string toJSON() const;
-  friend std::ostream& operator<<(std::ostream &os, Areas areas);
+  void writeJSON(std::ostream &os) const;
+  friend std::ostream& operator<<(std::ostream &os, const Areas& areas);
 };
 
 #endif // AREAS_H
\ No newline at end of file
@@ -0,0 +1,669 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the benchmark suite, built with `build.sh bench` into
+  bin/bethyw-bench. It times each stage of a run of Beth Yw? on the files in
+  the datasets directory:
+
+    populate/...  parsing each dataset into an Areas instance, unfiltered and
+                  filtered to one area and year, and all of them together
+    areas/...     Areas::setArea(), Areas::getArea() and
+                  Areas::getMeasureSummary()
+    measure/...   the statistics functions of Measure
+    render/...    the table output of operator<< and the JSON output of
+                  Areas::toJSON()
+
+  Each benchmark is run once to warm up, and then repeatedly until it has
+  run for at least --min-time seconds and at least five times. The latency
+  of each run is recorded, and the median, 90th and 99th percentiles are
+  reported along with the throughput (in the benchmark's unit, and in MB/s
+  of input or output where that makes sense) and the number of heap
+  allocations per run.
+
+  With --json FILE the results are also written as JSON, one object per
+  benchmark, for tracking regressions between builds.
+
+  With --generate DIR, synthetic datasets of the size given by --areas,
+  --measures, --years and --rows are written to DIR first (see
+  generator.h), and the benchmarks are run on those instead.
+
+  @example
+    bash build.sh bench
+    ./bin/bethyw-bench
+    ./bin/bethyw-bench --filter populate/ --json bench.json
+    ./bin/bethyw-bench --generate /tmp/bethyw-10k --areas 10000 --years 50
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#include "../lib_cxxopts.hpp"
+#include "../lib_json.hpp"
+
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../datasets.h"
+#include "../filter.h"
+#include "../input.h"
+#include "../runstats.h"
+#include "generator.h"
+
+namespace {
+
+/*
+  Written to by every benchmark, so the compiler cannot drop the work whose
+  result it holds.
+*/
+volatile double sink = 0;
+
+/*
+  A stream buffer that counts what is written to it and throws it away, like
+  writing to /dev/null, so that rendering can be timed without also timing
+  the growth of a std::ostringstream.
+*/
+class DiscardBuffer : public std::streambuf {
+  public:
+    std::streamsize written = 0;
+
+  protected:
+    int_type overflow(int_type c) override {
+      written++;
+      return traits_type::not_eof(c);
+    }
+
+    std::streamsize xsputn(const char_type* s, std::streamsize count) override {
+      (void) s;
+      written += count;
+      return count;
+    }
+};
+
+/*
+  A benchmark: a function to time, and how much work one call of it does.
+  items is counted in unit (e.g. rows parsed), and bytes is the size of the
+  input read or output written, or 0 where neither applies.
+*/
+struct Benchmark {
+  std::string name;
+  std::string unit;
+  double items;
+  double bytes;
+  std::function<void()> run;
+};
+
+/*
+  The timings and allocation counts of one benchmark.
+*/
+struct Result {
+  std::string name;
+  std::string unit;
+  std::size_t iterations = 0;
+  double items = 0;
+  double bytes = 0;
+  double minNs = 0;
+  double medianNs = 0;
+  double p90Ns = 0;
+  double p99Ns = 0;
+  double maxNs = 0;
+  double meanNs = 0;
+  double allocationsPerRun = 0;
+  double allocatedBytesPerRun = 0;
+};
+
+// The value below which a fraction of the sorted latencies fall
+double percentile(const std::vector<double>& sorted, double fraction) {
+  const std::size_t index = static_cast<std::size_t>(
+      fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+/*
+  Run a benchmark once to warm up, then repeatedly for at least minTime
+  seconds and at least five times (but at most a million), timing each run.
+*/
+Result measure(const Benchmark& benchmark, double minTime) {
+  using Clock = std::chrono::steady_clock;
+
+  benchmark.run();
+
+  std::vector<double> latencies;
+  std::uint64_t runAllocations = 0;
+  std::uint64_t runAllocatedBytes = 0;
+  const auto start = Clock::now();
+  const auto minDuration = std::chrono::duration<double>(minTime);
+  do{
+    // counted around the run only, not the latencies vector growing
+    const std::uint64_t allocationsBefore = RunStats::allocations();
+    const std::uint64_t allocatedBytesBefore = RunStats::allocatedBytes();
+    const auto before = Clock::now();
+    benchmark.run();
+    const auto after = Clock::now();
+    runAllocations += RunStats::allocations() - allocationsBefore;
+    runAllocatedBytes += RunStats::allocatedBytes() - allocatedBytesBefore;
+    latencies.push_back(
+        std::chrono::duration<double, std::nano>(after - before).count());
+  } while((Clock::now() - start < minDuration || latencies.size() < 5) &&
+          latencies.size() < 1000000);
+
+  Result result;
+  result.name = benchmark.name;
+  result.unit = benchmark.unit;
+  result.items = benchmark.items;
+  result.bytes = benchmark.bytes;
+  result.iterations = latencies.size();
+  const double runs = static_cast<double>(result.iterations);
+  result.allocationsPerRun = static_cast<double>(runAllocations) / runs;
+  result.allocatedBytesPerRun = static_cast<double>(runAllocatedBytes) / runs;
+
+  double total = 0;
+  for(const double latency : latencies){
+    total += latency;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  result.minNs = latencies.front();
+  result.medianNs = percentile(latencies, 0.5);
+  result.p90Ns = percentile(latencies, 0.9);
+  result.p99Ns = percentile(latencies, 0.99);
+  result.maxNs = latencies.back();
+  result.meanNs = total / runs;
+  return result;
+}
+
+// Work per second at the median latency
+double perSecond(double amount, const Result& result) {
+  return amount * 1e9 / result.medianNs;
+}
+
+// A latency in the most readable unit, e.g. "12.3 us"
+std::string formatNs(double ns) {
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(1);
+  if(ns >= 1e9){
+    os << ns / 1e9 << " s";
+  }else if(ns >= 1e6){
+    os << ns / 1e6 << " ms";
+  }else if(ns >= 1e3){
+    os << ns / 1e3 << " us";
+  }else{
+    os << ns << " ns";
+  }
+  return os.str();
+}
+
+void printHeader(std::ostream& os) {
+  os << std::left << std::setw(40) << "benchmark"
+     << std::right << std::setw(9) << "runs"
+     << std::setw(11) << "median"
+     << std::setw(11) << "p90"
+     << std::setw(11) << "p99"
+     << std::setw(22) << "throughput"
+     << std::setw(10) << "MB/s"
+     << std::setw(12) << "allocs/run" << '\n';
+}
+
+void printResult(std::ostream& os, const Result& result) {
+  std::ostringstream throughput;
+  throughput << std::fixed << std::setprecision(0)
+             << perSecond(result.items, result) << ' ' << result.unit << "/s";
+  std::ostringstream megabytes;
+  if(result.bytes > 0){
+    megabytes << std::fixed << std::setprecision(1)
+              << perSecond(result.bytes, result) / 1e6;
+  }else{
+    megabytes << '-';
+  }
+
+  os << std::left << std::setw(40) << result.name
+     << std::right << std::setw(9) << result.iterations
+     << std::setw(11) << formatNs(result.medianNs)
+     << std::setw(11) << formatNs(result.p90Ns)
+     << std::setw(11) << formatNs(result.p99Ns)
+     << std::setw(22) << throughput.str()
+     << std::setw(10) << megabytes.str()
+     << std::setw(12) << std::fixed << std::setprecision(1)
+     << result.allocationsPerRun << '\n';
+}
+
+nlohmann::json toJSON(const Result& result) {
+  return nlohmann::json{
+      {"name", result.name},
+      {"unit", result.unit},
+      {"iterations", result.iterations},
+      {"items", result.items},
+      {"bytes", result.bytes},
+      {"ns", {{"min", result.minNs},
+              {"median", result.medianNs},
+              {"p90", result.p90Ns},
+              {"p99", result.p99Ns},
+              {"max", result.maxNs},
+              {"mean", result.meanNs}}},
+      {"items_per_second", perSecond(result.items, result)},
+      {"bytes_per_second", perSecond(result.bytes, result)},
+      {"allocations_per_run", result.allocationsPerRun},
+      {"allocated_bytes_per_run", result.allocatedBytesPerRun}};
+}
+
+// The number of values held by all the Measures in an Areas instance
+double countValues(const Areas& areas) {
+  double values = 0;
+  for(const auto& area : areas.getAreasView()){
+    for(const auto& measure : area.second.getMeasuresView()){
+      values += measure.second.size();
+    }
+  }
+  return values;
+}
+
+/*
+  A dataset read into memory once, so that the populate benchmarks time the
+  parser and not the disk. The file stays mapped for the whole run.
+*/
+struct LoadedDataset {
+  BethYw::InputFileSource source;
+  std::unique_ptr<MappedInputFile> file;
+  std::string_view data;
+};
+
+/*
+  The benchmarks over the files in dir. Everything a benchmark reads is set
+  up here, outside the timed function.
+*/
+std::vector<Benchmark> makeBenchmarks(const std::string& dir) {
+  std::vector<Benchmark> benchmarks;
+
+  // One memory-mapped file per dataset, and areas.csv
+  auto datasets = std::make_shared<std::vector<LoadedDataset>>();
+  datasets->push_back({BethYw::InputFiles::AREAS, nullptr, {}});
+  for(const auto& source : BethYw::InputFiles::DATASETS){
+    datasets->push_back({source, nullptr, {}});
+  }
+  double allBytes = 0;
+  for(auto& dataset : *datasets){
+    dataset.file = std::make_unique<MappedInputFile>(dir + dataset.source.FILE);
+    dataset.data = dataset.file->open();
+    allBytes += dataset.data.size();
+  }
+
+  // Every dataset imported, as bethyw does with no arguments
+  auto all = std::make_shared<Areas>(Areas::Arena);
+  for(const auto& dataset : *datasets){
+    all->populate(dataset.data, dataset.source.PARSER, dataset.source.COLS,
+                  FilterSpec());
+  }
+  const double allValues = countValues(*all);
+
+  // The filters of `bethyw -a W06000024 -y 2015`
+  auto filtered = std::make_shared<FilterSpec>(
+      [] {
+        const StringFilterSet areasFilter = {"W06000024"};
+        const YearFilterTuple yearsFilter(2015, 2015);
+        return FilterSpec(&areasFilter, nullptr, &yearsFilter);
+      }());
+
+  for(const auto& dataset : *datasets){
+    const LoadedDataset* loaded = &dataset;
+
+    Areas once;
+    once.populate(loaded->data, loaded->source.PARSER, loaded->source.COLS,
+                  FilterSpec());
+    const double values = loaded->source.PARSER == BethYw::AuthorityCodeCSV
+                              ? once.size()
+                              : countValues(once);
+    const std::string unit =
+        loaded->source.PARSER == BethYw::AuthorityCodeCSV ? "areas" : "values";
+
+    benchmarks.push_back({
+        "populate/" + loaded->source.CODE, unit, values,
+        static_cast<double>(loaded->data.size()),
+        [datasets, loaded] {
+          Areas areas(Areas::Arena);
+          areas.populate(loaded->data, loaded->source.PARSER,
+                         loaded->source.COLS, FilterSpec());
+          sink = sink + areas.size();
+        }});
+
+    if(loaded->source.PARSER != BethYw::AuthorityCodeCSV){
+      benchmarks.push_back({
+          "populate/" + loaded->source.CODE + "/filtered", unit, values,
+          static_cast<double>(loaded->data.size()),
+          [datasets, loaded, filtered] {
+            Areas areas(Areas::Arena);
+            areas.populate(loaded->data, loaded->source.PARSER,
+                           loaded->source.COLS, *filtered);
+            sink = sink + areas.size();
+          }});
+    }
+
+    // As with --threads 4, where each thread interns the codes of its rows
+    // through its own SymbolCache
+    if(loaded->source.PARSER == BethYw::WelshStatsJSON){
+      benchmarks.push_back({
+          "populate/" + loaded->source.CODE + "/threads", unit, values,
+          static_cast<double>(loaded->data.size()),
+          [datasets, loaded] {
+            Areas areas(Areas::Arena);
+            areas.populate(loaded->data, loaded->source.PARSER,
+                           loaded->source.COLS, FilterSpec(), 4);
+            sink = sink + areas.size();
+          }});
+    }
+  }
+
+  benchmarks.push_back({
+      "populate/all", "values", allValues, allBytes,
+      [datasets] {
+        Areas areas(Areas::Arena);
+        for(const auto& dataset : *datasets){
+          areas.populate(dataset.data, dataset.source.PARSER,
+                         dataset.source.COLS, FilterSpec());
+        }
+        sink = sink + areas.size();
+      }});
+
+  // The local authority codes, and every measure codename, of the datasets
+  auto codes = std::make_shared<std::vector<std::string>>();
+  auto codenames = std::make_shared<std::vector<std::string>>();
+  {
+    std::unordered_set<std::string> seen;
+    for(const auto& area : all->getAreasView()){
+      codes->push_back(area.first);
+      for(const auto& measure : area.second.getMeasuresView()){
+        if(seen.insert(measure.first).second){
+          codenames->push_back(measure.first);
+        }
+      }
+    }
+  }
+
+  benchmarks.push_back({
+      "areas/setArea", "areas", static_cast<double>(codes->size()), 0,
+      [codes] {
+        Areas areas;
+        for(const auto& code : *codes){
+          areas.setArea(code, Area(code));
+        }
+        sink = sink + areas.size();
+      }});
+
+  const std::size_t lookupRounds = 100;
+  benchmarks.push_back({
+      "areas/getArea", "lookups",
+      static_cast<double>(codes->size() * lookupRounds), 0,
+      [all, codes, lookupRounds] {
+        const Areas& areas = *all;
+        double found = 0;
+        for(std::size_t i = 0; i < lookupRounds; i++){
+          for(const auto& code : *codes){
+            found += areas.getArea(code).size();
+          }
+        }
+        sink = sink + found;
+      }});
+
+  benchmarks.push_back({
+      "areas/getMeasureSummary", "measures",
+      static_cast<double>(codenames->size()), 0,
+      [all, codenames] {
+        double total = 0;
+        for(const auto& codename : *codenames){
+          total += all->getMeasureSummary(codename).mean;
+        }
+        sink = sink + total;
+      }});
+
+  double measures = 0;
+  for(const auto& area : all->getAreasView()){
+    measures += area.second.size();
+  }
+  benchmarks.push_back({
+      "measure/statistics", "measures", measures, 0,
+      [all] {
+        double total = 0;
+        for(const auto& area : all->getAreasView()){
+          for(const auto& measure : area.second.getMeasuresView()){
+            total += measure.second.getAverage() +
+                     measure.second.getDifference() +
+                     measure.second.getDifferenceAsPercentage() +
+                     measure.second.getVariance();
+          }
+        }
+        sink = sink + total;
+      }});
+
+  // a large area filter, such as a QueryServer compiles for a query
+  auto manyCodes = std::make_shared<StringFilterSet>();
+  for(std::size_t i = 0; i < 1000; i++){
+    manyCodes->insert("W" + std::to_string(6000000 + i));
+  }
+  benchmarks.push_back({
+      "filter/build", "areas", static_cast<double>(manyCodes->size()), 0,
+      [manyCodes] {
+        const FilterSpec filter(manyCodes.get(), nullptr, nullptr);
+        sink = sink + filter.acceptsArea("W6000000");
+      }});
+
+  auto manyAreas = std::make_shared<FilterSpec>(manyCodes.get(), nullptr,
+                                                nullptr);
+  benchmarks.push_back({
+      "filter/acceptsArea", "lookups",
+      static_cast<double>(codes->size() * lookupRounds), 0,
+      [manyAreas, codes, lookupRounds] {
+        double accepted = 0;
+        for(std::size_t i = 0; i < lookupRounds; i++){
+          for(const auto& code : *codes){
+            accepted += manyAreas->acceptsArea(code);
+          }
+        }
+        sink = sink + accepted;
+      }});
+
+  std::ostringstream table;
+  table << *all;
+  benchmarks.push_back({
+      "render/table", "values", allValues,
+      static_cast<double>(table.str().size()),
+      [all] {
+        std::ostringstream os;
+        os << *all;
+        sink = sink + static_cast<double>(os.tellp());
+      }});
+
+  // areas.csv and the StatsWales JSON datasets, printed as tables to a
+  // stream that discards them: only the stream operators are timed
+  auto printed = std::make_shared<Areas>(Areas::Arena);
+  for(const auto& dataset : *datasets){
+    if(dataset.source.PARSER != BethYw::AuthorityByYearCSV){
+      printed->populate(dataset.data, dataset.source.PARSER,
+                        dataset.source.COLS, FilterSpec());
+    }
+  }
+  DiscardBuffer printedSize;
+  std::ostream(&printedSize) << *printed;
+  benchmarks.push_back({
+      "render/table/discard", "values", countValues(*printed),
+      static_cast<double>(printedSize.written),
+      [printed] {
+        DiscardBuffer buffer;
+        std::ostream os(&buffer);
+        os << *printed;
+        sink = sink + static_cast<double>(buffer.written);
+      }});
+
+  benchmarks.push_back({
+      "render/json", "values", allValues,
+      static_cast<double>(all->toJSON().size()),
+      [all] {
+        sink = sink + all->toJSON().size();
+      }});
+
+  return benchmarks;
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+  cxxopts::Options cxxopts(
+      "bethyw-bench",
+      "Benchmarks for Beth Yw?, run on the files in the datasets directory\n");
+  cxxopts.add_options()(
+      "dir",
+      "Directory for input data passed in as files",
+      cxxopts::value<std::string>()->default_value("datasets"))(
+
+      "f,filter",
+      "Only run the benchmarks whose names contain this text",
+      cxxopts::value<std::string>()->default_value(""))(
+
+      "min-time",
+      "The minimum time to run each benchmark for, in seconds",
+      cxxopts::value<double>()->default_value("0.5"))(
+
+      "json",
+      "Also write the results as JSON to this file ('-' for the standard "
+      "output, in place of the table)",
+      cxxopts::value<std::string>())(
+
+      "generate",
+      "Generate synthetic datasets into this directory and run the "
+      "benchmarks on them instead of --dir",
+      cxxopts::value<std::string>())(
+
+      "generate-only",
+      "Stop after generating the datasets")(
+
+      "areas",
+      "The number of areas to generate",
+      cxxopts::value<unsigned int>()->default_value("22"))(
+
+      "measures",
+      "The number of measures to generate in each dataset that has several",
+      cxxopts::value<unsigned int>()->default_value("4"))(
+
+      "years",
+      "The number of years to generate",
+      cxxopts::value<unsigned int>()->default_value("20"))(
+
+      "first-year",
+      "The first year to generate",
+      cxxopts::value<int>()->default_value("2000"))(
+
+      "rows",
+      "The rough number of rows to generate in each JSON dataset "
+      "(0 for one per area, measure and year)",
+      cxxopts::value<std::uint64_t>()->default_value("0"))(
+
+      "seed",
+      "The seed to generate with; the same seed and sizes always give the "
+      "same files",
+      cxxopts::value<std::uint64_t>()->default_value("1"))(
+
+      "h,help",
+      "Print usage.");
+
+  try{
+    auto args = cxxopts.parse(argc, argv);
+    if(args.count("help")){
+      std::cerr << cxxopts.help() << std::endl;
+      return 0;
+    }
+
+    std::string dir = args["dir"].as<std::string>() + DIR_SEP;
+    nlohmann::json generated;
+    if(args.count("generate")){
+      DatasetGenerator::Options options;
+      options.areas = args["areas"].as<unsigned int>();
+      options.measures = args["measures"].as<unsigned int>();
+      options.years = args["years"].as<unsigned int>();
+      options.firstYear = args["first-year"].as<int>();
+      options.rows = args["rows"].as<std::uint64_t>();
+      options.seed = args["seed"].as<std::uint64_t>();
+
+      const std::string generateDir = args["generate"].as<std::string>();
+      const std::uint64_t bytes = DatasetGenerator(options).writeAll(generateDir);
+      std::cerr << "Generated " << bytes << " bytes of datasets in "
+                << generateDir << std::endl;
+      if(args.count("generate-only")){
+        return 0;
+      }
+
+      dir = generateDir + DIR_SEP;
+      generated = {{"areas", options.areas},
+                   {"measures", options.measures},
+                   {"years", options.years},
+                   {"first_year", options.firstYear},
+                   {"rows", options.rows},
+                   {"seed", options.seed},
+                   {"bytes", bytes}};
+    }
+    const std::string filter = args["filter"].as<std::string>();
+    const double minTime = args["min-time"].as<double>();
+    const std::string jsonFile = args.count("json")
+                                     ? args["json"].as<std::string>()
+                                     : std::string();
+    const bool tableToStdout = jsonFile != "-";
+
+    if(tableToStdout){
+      printHeader(std::cout);
+    }
+    nlohmann::json results = nlohmann::json::array();
+    for(const auto& benchmark : makeBenchmarks(dir)){
+      if(benchmark.name.find(filter) == std::string::npos){
+        continue;
+      }
+      const Result result = measure(benchmark, minTime);
+      if(tableToStdout){
+        printResult(std::cout, result);
+        std::cout.flush();
+      }
+      results.push_back(toJSON(result));
+    }
+
+    if(!jsonFile.empty()){
+      nlohmann::json report = {
+          {"context", {{"dir", dir},
+                       {"generated", generated},
+                       {"min_time", minTime},
+#if defined(__VERSION__)
+                       {"compiler", __VERSION__},
+#endif
+                       {"hardware_threads", std::thread::hardware_concurrency()}}},
+          {"benchmarks", results}};
+      if(jsonFile == "-"){
+        std::cout << report.dump(2) << std::endl;
+      }else{
+        std::ofstream os(jsonFile);
+        os << report.dump(2) << std::endl;
+        if(!os){
+          throw std::runtime_error("Could not write " + jsonFile);
+        }
+      }
+    }
+  } catch(const std::exception& ex){
+    std::cerr << "bethyw-bench: " << ex.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
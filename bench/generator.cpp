@@ -0,0 +1,370 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the DatasetGenerator class. See
+  the header file for additional comments.
+*/
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+
+#include "generator.h"
+
+namespace {
+
+// The size the output buffer reaches before it is written out
+const std::size_t FLUSH_SIZE = 1 << 16;
+
+// Values are written with this many decimal places
+const int VALUE_PRECISION = 3;
+
+// The part of a column name before its first underscore, e.g. "Year" for
+// "Year_Code", for naming the extra columns that go with it
+std::string columnPrefix(const std::string& column) {
+  const std::size_t underscore = column.find('_');
+  return underscore == std::string::npos ? column : column.substr(0, underscore);
+}
+
+void appendNumber(std::string& buffer, double value) {
+  char digits[64];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value,
+                              std::chars_format::fixed, VALUE_PRECISION);
+  buffer.append(digits, result.ptr);
+}
+
+void appendNumber(std::string& buffer, std::uint64_t value) {
+  char digits[32];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  buffer.append(digits, result.ptr);
+}
+
+// A number zero-padded to a width, e.g. the RowKey of a StatsWales row
+void appendPadded(std::string& buffer, std::uint64_t value, std::size_t width) {
+  char digits[32];
+  auto result = std::to_chars(digits, digits + sizeof(digits), value);
+  const std::size_t length = result.ptr - digits;
+  if(length < width){
+    buffer.append(width - length, '0');
+  }
+  buffer.append(digits, length);
+}
+
+void flush(std::ostream& os, std::string& buffer, bool force = false) {
+  if(force || buffer.size() >= FLUSH_SIZE){
+    os.write(buffer.data(), buffer.size());
+    buffer.clear();
+  }
+}
+
+// FNV-1a, to give each dataset its own random stream from the same seed
+std::uint64_t hashCode(std::string_view text) {
+  std::uint64_t hash = 14695981039346656037ull;
+  for(const char c : text){
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+} // namespace
+
+/*
+  The splitmix64 generator: small, fast, and the same on every platform.
+*/
+class DatasetGenerator::Random {
+  private:
+    std::uint64_t state;
+  public:
+    explicit Random(std::uint64_t seed) : state(seed) {}
+
+    std::uint64_t next() {
+      std::uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+      return z ^ (z >> 31);
+    }
+
+    // uniform in [0, 1)
+    double nextDouble() {
+      return static_cast<double>(next() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+/*
+  DatasetGenerator::DatasetGenerator(options)
+
+  @param options
+    The size and seed of the datasets to generate
+
+  @throws
+    std::invalid_argument if there are no areas, measures or years, or the
+    first year is negative
+*/
+DatasetGenerator::DatasetGenerator(const Options& options) : options(options) {
+  if(options.areas == 0 || options.measures == 0 || options.years == 0){
+    throw std::invalid_argument(
+        "DatasetGenerator: There must be at least one area, measure and year");
+  }
+  if(options.firstYear < 0){
+    throw std::invalid_argument("DatasetGenerator: Years cannot be negative");
+  }
+}
+
+/*
+  DatasetGenerator::getLocalAuthorityCode(area)
+
+  @param area
+    The index of an area, from 0
+
+  @return
+    The local authority code of the area, which follows on from the Welsh
+    codes, e.g. W06000001 for the first
+*/
+std::string DatasetGenerator::getLocalAuthorityCode(unsigned int area) const {
+  std::string code = "W";
+  appendPadded(code, 6000001ull + area, 8);
+  return code;
+}
+
+/*
+  DatasetGenerator::keepValue(random, measures)
+
+  Decide whether to include the next value of a dataset with the given number
+  of measures, so that it has about options.rows values.
+*/
+bool DatasetGenerator::keepValue(Random& random, unsigned int measures) const {
+  if(options.rows == 0){
+    return true;
+  }
+  const double cells = static_cast<double>(options.areas) * measures *
+                       options.years;
+  const double fraction = static_cast<double>(options.rows) / cells;
+  return fraction >= 1 || random.nextDouble() < fraction;
+}
+
+/*
+  DatasetGenerator::writeAll(dir)
+
+  Write areas.csv and every dataset into a directory, creating it if needed.
+
+  @param dir
+    The directory to write to
+
+  @return
+    The total size of the files written, in bytes
+
+  @throws
+    std::runtime_error if a file cannot be written
+*/
+std::uint64_t DatasetGenerator::writeAll(const std::string& dir) const {
+  namespace fs = std::filesystem;
+  fs::create_directories(dir);
+
+  std::uint64_t bytes = 0;
+  auto write = [&](const BethYw::InputFileSource& source) {
+    const fs::path path = fs::path(dir) / source.FILE;
+    {
+      std::ofstream os(path, std::ios::binary);
+      if(!os){
+        throw std::runtime_error("DatasetGenerator: Could not open " +
+                                 path.string());
+      }
+      switch(source.PARSER){
+        case BethYw::AuthorityCodeCSV:
+          writeAreasCSV(os);
+          break;
+        case BethYw::WelshStatsJSON:
+          writeWelshStatsJSON(os, source);
+          break;
+        case BethYw::AuthorityByYearCSV:
+          writeAuthorityByYearCSV(os, source);
+          break;
+        default:
+          throw std::runtime_error("DatasetGenerator: Unexpected data type");
+      }
+      if(!os.flush()){
+        throw std::runtime_error("DatasetGenerator: Could not write " +
+                                 path.string());
+      }
+    }
+    bytes += fs::file_size(path);
+  };
+
+  write(BethYw::InputFiles::AREAS);
+  for(const auto& source : BethYw::InputFiles::DATASETS){
+    write(source);
+  }
+  return bytes;
+}
+
+/*
+  DatasetGenerator::writeAreasCSV(os)
+
+  Write areas.csv, with an English and a Welsh name for every area.
+
+  @param os
+    The stream to write to
+
+  @return
+    The number of areas written
+*/
+std::uint64_t DatasetGenerator::writeAreasCSV(std::ostream& os) const {
+  const auto& cols = BethYw::InputFiles::AREAS.COLS;
+  std::string buffer = cols.at(BethYw::AUTH_CODE) + "," +
+                       cols.at(BethYw::AUTH_NAME_ENG) + "," +
+                       cols.at(BethYw::AUTH_NAME_CYM) + "\n";
+  for(unsigned int area = 0; area < options.areas; area++){
+    buffer += getLocalAuthorityCode(area);
+    buffer += ",Area ";
+    appendNumber(buffer, static_cast<std::uint64_t>(area) + 1);
+    buffer += ",Ardal ";
+    appendNumber(buffer, static_cast<std::uint64_t>(area) + 1);
+    buffer += '\n';
+    flush(os, buffer);
+  }
+  flush(os, buffer, true);
+  return options.areas;
+}
+
+/*
+  DatasetGenerator::writeWelshStatsJSON(os, source)
+
+  Write a StatsWales JSON file for a dataset, with one row per value, in
+  order of area, then measure, then year.
+
+  @param os
+    The stream to write to
+
+  @param source
+    The dataset, whose column mapping gives the keys of each row
+
+  @return
+    The number of rows written
+*/
+std::uint64_t DatasetGenerator::writeWelshStatsJSON(
+    std::ostream& os,
+    const BethYw::InputFileSource& source) const {
+  const auto& cols = source.COLS;
+  const bool singleMeasure = cols.count(BethYw::MEASURE_CODE) == 0;
+  const unsigned int measures = singleMeasure ? 1 : options.measures;
+
+  const std::string& codeColumn = cols.at(BethYw::AUTH_CODE);
+  const std::string& nameColumn = cols.at(BethYw::AUTH_NAME_ENG);
+  const std::string& yearColumn = cols.at(BethYw::YEAR);
+  const std::string& valueColumn = cols.at(BethYw::VALUE);
+  const std::string measureCodeColumn =
+      singleMeasure ? "" : cols.at(BethYw::MEASURE_CODE);
+  const std::string measureNameColumn =
+      singleMeasure ? "" : cols.at(BethYw::MEASURE_NAME);
+  const std::string areaPrefix = columnPrefix(codeColumn);
+  const std::string measurePrefix = columnPrefix(measureCodeColumn);
+  const std::string yearPrefix = columnPrefix(yearColumn);
+
+  Random random(options.seed ^ hashCode(source.CODE));
+  std::string buffer = "{\n  \"odata.metadata\":\"synthetic#" + source.CODE +
+                       "\",\"value\":[\n";
+  std::uint64_t rows = 0;
+  for(unsigned int area = 0; area < options.areas; area++){
+    const std::string code = getLocalAuthorityCode(area);
+    for(unsigned int measure = 0; measure < measures; measure++){
+      // each series grows steadily from its own starting value
+      const double base = 10 + random.nextDouble() * 100000;
+      for(unsigned int year = 0; year < options.years; year++){
+        const double value = base * (1 + 0.02 * year) *
+                             (0.95 + 0.1 * random.nextDouble());
+        if(!keepValue(random, measures)){
+          continue;
+        }
+
+        buffer += rows == 0 ? "    {\n" : "    },{\n";
+        buffer += "      \"" + valueColumn + "\":";
+        appendNumber(buffer, value);
+        buffer += ",\"" + codeColumn + "\":\"" + code + "\"";
+        buffer += ",\"" + nameColumn + "\":\"Area ";
+        appendNumber(buffer, static_cast<std::uint64_t>(area) + 1);
+        buffer += "\",\"" + areaPrefix + "_SortOrder\":\"";
+        appendNumber(buffer, static_cast<std::uint64_t>(area) + 1);
+        buffer += "\"";
+        if(!singleMeasure){
+          buffer += ",\"" + measureCodeColumn + "\":\"";
+          // some datasets use the measure name as its code
+          buffer += measureCodeColumn == measureNameColumn ? "Measure " : "M";
+          appendNumber(buffer, static_cast<std::uint64_t>(measure) + 1);
+          buffer += "\"";
+          if(measureNameColumn != measureCodeColumn){
+            buffer += ",\"" + measureNameColumn + "\":\"Measure ";
+            appendNumber(buffer, static_cast<std::uint64_t>(measure) + 1);
+            buffer += "\"";
+          }
+          buffer += ",\"" + measurePrefix + "_SortOrder\":\"";
+          appendNumber(buffer, static_cast<std::uint64_t>(measure) + 1);
+          buffer += "\"";
+        }
+        buffer += ",\"" + yearColumn + "\":\"";
+        appendNumber(buffer, static_cast<std::uint64_t>(options.firstYear + year));
+        buffer += "\",\"" + yearPrefix + "_ItemName_ENG\":\"Year ";
+        appendNumber(buffer, static_cast<std::uint64_t>(options.firstYear + year));
+        buffer += "\",\"RowKey\":\"";
+        appendPadded(buffer, rows, 16);
+        buffer += "\",\"PartitionKey\":\"\"\n";
+        rows++;
+        flush(os, buffer);
+      }
+    }
+  }
+  buffer += rows == 0 ? "  ]" : "    }\n  ]";
+  buffer += ",\"odata.nextLink\":\"\"\n}\n";
+  flush(os, buffer, true);
+  return rows;
+}
+
+/*
+  DatasetGenerator::writeAuthorityByYearCSV(os, source)
+
+  Write a CSV file for a dataset with a single measure, with one row per area
+  and one column per year, and a value in every cell.
+
+  @param os
+    The stream to write to
+
+  @param source
+    The dataset, whose column mapping gives the name of the first column
+
+  @return
+    The number of values written
+*/
+std::uint64_t DatasetGenerator::writeAuthorityByYearCSV(
+    std::ostream& os,
+    const BethYw::InputFileSource& source) const {
+  Random random(options.seed ^ hashCode(source.CODE));
+  std::string buffer = source.COLS.at(BethYw::AUTH_CODE);
+  for(unsigned int year = 0; year < options.years; year++){
+    buffer += ',';
+    appendNumber(buffer, static_cast<std::uint64_t>(options.firstYear + year));
+  }
+  buffer += '\n';
+
+  for(unsigned int area = 0; area < options.areas; area++){
+    buffer += getLocalAuthorityCode(area);
+    const double base = 10 + random.nextDouble() * 100000;
+    for(unsigned int year = 0; year < options.years; year++){
+      buffer += ',';
+      appendNumber(buffer, base * (1 + 0.02 * year) *
+                               (0.95 + 0.1 * random.nextDouble()));
+    }
+    buffer += '\n';
+    flush(os, buffer);
+  }
+  flush(os, buffer, true);
+  return static_cast<std::uint64_t>(options.areas) * options.years;
+}
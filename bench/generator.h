@@ -0,0 +1,81 @@
+#ifndef GENERATOR_H_
+#define GENERATOR_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the DatasetGenerator class, which writes synthetic
+  datasets in the same formats and with the same column names as the files
+  in the datasets directory, at any size, for the benchmarks.
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+#include "../datasets.h"
+
+/*
+  A DatasetGenerator writes a directory that can be used in place of the
+  datasets directory (e.g. with bethyw --dir, or bethyw-bench --dir):
+  areas.csv, and a file for every dataset in BethYw::InputFiles::DATASETS
+  under the same name and with the columns given in its column mapping.
+
+  Every file covers the same areas and years. The WelshStatsJSON datasets
+  with a measure code column have the given number of measures each, and the
+  others have their single measure. JSON rows carry the same extra columns as
+  the StatsWales files (sort orders, row keys, etc.), so that the parser
+  skips as much as it does on real data.
+
+  The output depends only on the options: values come from a seeded
+  splitmix64 generator (rather than <random> distributions, whose output
+  differs between standard libraries), and each file has its own stream, so
+  the same seed always gives the same bytes.
+
+  @example
+    DatasetGenerator::Options options;
+    options.areas = 10000;
+    options.years = 50;
+    DatasetGenerator generator(options);
+    generator.writeAll("datasets-10k");
+*/
+class DatasetGenerator {
+  public:
+    struct Options {
+      // the number of local authorities
+      unsigned int areas = 22;
+      // the number of measures in each dataset with a measure code column
+      unsigned int measures = 4;
+      // the number of consecutive years, from firstYear
+      unsigned int years = 20;
+      int firstYear = 2000;
+      // the rough number of values in each WelshStatsJSON dataset, with
+      // each (area, measure, year) left out at random to get it, or 0 to
+      // include every one
+      std::uint64_t rows = 0;
+      std::uint64_t seed = 1;
+    };
+
+  private:
+    Options options;
+
+    class Random;
+    bool keepValue(Random& random, unsigned int measures) const;
+  public:
+    explicit DatasetGenerator(const Options& options);
+    std::string getLocalAuthorityCode(unsigned int area) const;
+    std::uint64_t writeAll(const std::string& dir) const;
+    std::uint64_t writeAreasCSV(std::ostream& os) const;
+    std::uint64_t writeWelshStatsJSON(
+        std::ostream& os,
+        const BethYw::InputFileSource& source) const;
+    std::uint64_t writeAuthorityByYearCSV(
+        std::ostream& os,
+        const BethYw::InputFileSource& source) const;
+};
+
+#endif // GENERATOR_H_
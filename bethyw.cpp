@@ -25,20 +25,57 @@
   additional functions not specified.
 */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <iomanip>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_set>
 #include <vector>
 #include <typeinfo>
 
+#ifndef _WIN32
+#include <cerrno>
+#include <csignal>
+#include <unistd.h>
+#endif
+
 #include "lib_cxxopts.hpp"
 
 #include "areas.h"
 #include "datasets.h"
 #include "bethyw.h"
 #include "input.h"
+#include "runstats.h"
+#include "server.h"
+#include "snapshot.h"
+#include "threadpool.h"
+#include "trace.h"
+
+namespace {
+
+#ifndef _WIN32
+// The pipe stopServing() writes to when SIGINT or SIGTERM arrives during
+// --serve, as QueryServer::stop() cannot be called from a signal handler
+int stopPipe[2] = {-1, -1};
+
+void stopServing(int) {
+  const char byte = 0;
+  // write() is async-signal-safe; if it fails, a stop is already pending
+  const ssize_t written = ::write(stopPipe[1], &byte, 1);
+  (void) written;
+}
+#endif
+
+} // namespace
 
 /*
   Run Beth Yw?, parsing the command line arguments, importing the data,
@@ -57,6 +94,10 @@
     Exit code
 */
 int BethYw::run(int argc, char *argv[]) {
+  // Each phase of the run is timed, but only reported with --stats
+  RunStats runStats;
+  RunStats::Timer argumentsTimer(&runStats, "arguments");
+
   auto cxxopts = BethYw::cxxoptsSetup();
   auto args = cxxopts.parse(argc, argv);
 
@@ -73,37 +114,118 @@ int BethYw::run(int argc, char *argv[]) {
   auto areasFilter      = BethYw::parseAreasArg(args);
   auto measuresFilter   = BethYw::parseMeasuresArg(args);
   auto yearsFilter      = BethYw::parseYearsArg(args);
+  auto threads          = BethYw::parseThreadsArg(args);
+  auto statsFormat      = BethYw::parseStatsArg(args);
+
+  // The loading functions only count what they do with --stats
+  RunStats* stats = statsFormat.empty() ? nullptr : &runStats;
+
+  // The filters are compiled once and shared by every dataset imported
+  const YearFilterTuple yearsRange = yearsFilter;
+  const FilterSpec filter(&areasFilter, &measuresFilter, &yearsRange);
+  argumentsTimer.stop();
+
+  // Spans are only recorded by a build with tracing compiled in, see trace.h
+  std::string traceFile;
+  if(args.count("trace")){
+    traceFile = args["trace"].as<std::string>();
+    if(Trace::COMPILED_IN){
+      Trace::start();
+    }else{
+      std::cerr << "Tracing is not compiled in, rebuild with "
+                   "CXXFLAGS=-DBETHYW_TRACE to use --trace" << std::endl;
+    }
+  }
 
-  std::unordered_set<std::string>::const_iterator got = measuresFilter.find ("pop");
+  // Saves the trace and writes the stats once the run has finished, however
+  // it ends
+  auto report = [&traceFile, &statsFormat, &runStats]() {
+    if(Trace::COMPILED_IN && !traceFile.empty()){
+      Trace::stop();
+      BethYw::saveTrace(traceFile);
+    }
 
-  if ( got == measuresFilter.end() )
-    std::cout << "not found in myset";
-  else
-    std::cout << *got << " is in myset";
+    if(statsFormat == "json"){
+      runStats.writeJSON(std::cerr);
+    }else if(statsFormat == "text"){
+      runStats.writeText(std::cerr);
+    }
+  };
+
+  // The server loads the datasets itself, and answers queries until it is
+  // stopped by SIGINT or SIGTERM
+  if(args.count("serve")){
+    // unless the threads are given, answer as many clients at once as
+    // there are processor cores
+    const unsigned int clients = args.count("threads")
+        ? threads : std::max(1u, std::thread::hardware_concurrency());
+    const int exitCode = BethYw::serve(args["serve"].as<std::string>(),
+                                       dir,
+                                       datasetsToImport,
+                                       filter,
+                                       threads,
+                                       clients,
+                                       stats);
+    report();
+    return exitCode;
+  }
 
-  std::cout<<" measuresFilter ";
-  for(const auto&x:measuresFilter){
-     std::cout<<" "<<x<<" ";
+  // Everything imported lives until the program exits, so it is all allocated
+  // from one arena and released at once
+  Areas data(Areas::Arena);
+
+  // A snapshot is only valid for the exact same data directory, datasets and
+  // filters, so these all go into its filename
+  std::string snapshotFile;
+  if(args.count("cache")){
+    snapshotFile = BethYw::snapshotPath(args["cache"].as<std::string>(),
+                                        dir,
+                                        datasetsToImport,
+                                        areasFilter,
+                                        measuresFilter,
+                                        yearsFilter);
   }
-  
-  Areas data = Areas();
 
-  BethYw::loadAreas(data, dir, areasFilter);
-  
-  BethYw::loadDatasets(data,
-                      dir,
-                      datasetsToImport,
-                      areasFilter,
-                      measuresFilter,
-                      yearsFilter);
-  if (args.count("json")) {
-    // The output as JSON
-    std::cout << data.toJSON() << std::endl;
-  } else {
-    // The output as tables
-    std::cout <<"size: "<< data.size() <<"data: "<<data<< std::endl;
+  bool snapshotLoaded = false;
+  if(!snapshotFile.empty()){
+    RunStats::Timer timer(stats, "snapshot/load");
+    snapshotLoaded = BethYw::loadSnapshot(data, snapshotFile, dir,
+                                          datasetsToImport);
+    if(stats != nullptr && snapshotLoaded){
+      timer.counters() = BethYw::countContents(data);
+    }
   }
 
+  if(!snapshotLoaded){
+    BethYw::loadAreas(data, dir, filter, stats);
+
+    bool allImported = BethYw::loadDatasets(data,
+                                            dir,
+                                            datasetsToImport,
+                                            filter,
+                                            threads,
+                                            stats);
+
+    // Don't cache an import that failed, so the error is seen next time too
+    if(!snapshotFile.empty() && allImported){
+      RunStats::Timer timer(stats, "snapshot/save");
+      BethYw::saveSnapshot(data, snapshotFile);
+    }
+  }
+
+  {
+    RunStats::Timer timer(stats, "output");
+    if(args.count("json")){
+      // The output as JSON, written as it is generated
+      data.writeJSON(std::cout);
+      std::cout << std::endl;
+    }else{
+      // The output as tables
+      std::cout << data << std::endl;
+    }
+  }
+
+  report();
   return 0;
 }
 
@@ -151,6 +273,33 @@ cxxopts::Options BethYw::cxxoptsSetup() {
       "inclusive range of years (YYYY-ZZZZ)",
       cxxopts::value<std::string>()->default_value("0"))(
 
+      "t,threads",
+      "The number of threads to import the datasets with "
+      "(set to 0 to use one per processor core)",
+      cxxopts::value<std::string>()->default_value("1"))(
+
+      "cache",
+      "Directory for snapshots of the imported data, which are reused instead "
+      "of importing the datasets again while they are unchanged",
+      cxxopts::value<std::string>())(
+
+      "stats",
+      "Print the time taken, rows read and memory used by each phase of the "
+      "run to the standard error, as a table or as JSON (text or json)",
+      cxxopts::value<std::string>()->implicit_value("text"))(
+
+      "serve",
+      "Load the datasets once and answer queries (lines of the same "
+      "arguments as bethyw takes) on a Unix domain socket at this path, "
+      "with --threads clients at once, until interrupted",
+      cxxopts::value<std::string>())(
+
+      "trace",
+      "Write a trace of the time each thread spends on opening, parsing, "
+      "merging and printing the data to this file, in the Chrome trace "
+      "event format (only in builds with -DBETHYW_TRACE)",
+      cxxopts::value<std::string>())(
+
       "j,json",
       "Print the output as JSON instead of tables.")(
 
@@ -204,7 +353,6 @@ std::vector<BethYw::InputFileSource> BethYw::parseDatasetsArg(
   if(args.count("datasets")){
      inputDatasets = args["datasets"].as<std::vector<std::string>>();
   }else{
-    std::cout<<"all datasets imported";
     inputDatasets.push_back("all");
   }
   std::vector<int>::size_type inputSize = inputDatasets.size();
@@ -445,8 +593,118 @@ bool BethYw::is_number(const std::string& s)
     return !s.empty() && it == s.end();
 }
 
+/*
+  BethYw::parseThreadsArg(args)
+
+  Parse the threads command line argument, the number of threads to import
+  the datasets with. It defaults to 1, which imports the datasets one after
+  another. A value of 0 uses one thread per processor core.
+
+  @param args
+    Parsed program arguments
+
+  @return
+    The number of threads to use, which is at least 1
+
+  @throws
+    std::invalid_argument if the argument is not a whole number, with the
+    message: Invalid input for threads argument
+*/
+unsigned int BethYw::parseThreadsArg(cxxopts::ParseResult& args){
+  const std::string temp = args["threads"].as<std::string>();
+  if(!is_number(temp) || temp.size() > 4){
+    throw std::invalid_argument("Invalid input for threads argument");
+  }
+  unsigned int threads = std::stoul(temp);
+  if(threads == 0){
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  return threads;
+}
+
+/*
+  BethYw::parseStatsArg(args)
+
+  Parse the stats command line argument, which is optional. Given on its own
+  (--stats) it asks for the statistics of the run as a table, and given as
+  --stats=json it asks for them as JSON.
+
+  @param args
+    Parsed program arguments
+
+  @return
+    "text" or "json", or an empty string if no statistics were asked for
+
+  @throws
+    std::invalid_argument if the argument is neither text nor json, with the
+    message: Invalid input for stats argument
+*/
+std::string BethYw::parseStatsArg(cxxopts::ParseResult& args){
+  if(args.count("stats") == 0){
+    return "";
+  }
+  std::string format = args["stats"].as<std::string>();
+  std::transform(format.begin(), format.end(), format.begin(), ::tolower);
+  if(format != "text" && format != "json"){
+    throw std::invalid_argument("Invalid input for stats argument");
+  }
+  return format;
+}
+
+/*
+  BethYw::countContents(areas)
+
+  Count the Areas, Measures and values in an Areas instance, for the --stats
+  argument. The counts go in the created counters, so that the difference
+  between two counts is what was created in between.
+
+  @param areas
+    The Areas instance to count
+
+  @return
+    Counters with areasCreated, measuresCreated and valuesCreated set
+
+  @example
+    auto before = BethYw::countContents(areas);
+    BethYw::loadAreas(areas, dir, filter);
+    auto after = BethYw::countContents(areas);
+    auto created = after.areasCreated - before.areasCreated;
+*/
+RunStats::Counters BethYw::countContents(const Areas& areas){
+  RunStats::Counters counters;
+  for(auto const& x : areas.getAreasView()){
+    counters.areasCreated++;
+    for(auto const& measure : x.second.getMeasuresView()){
+      counters.measuresCreated++;
+      counters.valuesCreated += measure.second.size();
+    }
+  }
+  return counters;
+}
+
+namespace {
+
+// The counters of what was created or read between two counts, for --stats
+void setCreated(RunStats::Counters& counters,
+                const RunStats::Counters& before,
+                const RunStats::Counters& after){
+  counters.areasCreated = after.areasCreated - before.areasCreated;
+  counters.measuresCreated = after.measuresCreated - before.measuresCreated;
+  counters.valuesCreated = after.valuesCreated - before.valuesCreated;
+}
+
+void setRows(RunStats::Counters& counters,
+             const ImportCounts& before,
+             const ImportCounts& after){
+  counters.rowsParsed = after.rowsParsed - before.rowsParsed;
+  counters.rowsFiltered = after.rowsFiltered - before.rowsFiltered;
+}
+
+} // namespace
+
 /*
   TODO: BethYw::loadAreas(areas, dir, areasFilter)
+        BethYw::loadAreas(areas, dir, filter, stats)
 
   Load the areas.csv file from the directory `dir`. Parse the file and
   create the appropriate Area objects inside the Areas object passed to
@@ -462,6 +720,9 @@ bool BethYw::is_number(const std::string& s)
   Hint 2: you can retrieve the specific filename for a dataset, e.g. for the 
   areas.csv file, from the InputFileSource's FILE member variable
 
+  The file is memory-mapped with MappedInputFile and its contents are passed
+  to Areas::populate() as a view, rather than being read through a stream.
+
   @param areas
     An Areas instance that should be modified (i.e. the populate() function
     in the instance should be called)
@@ -472,6 +733,12 @@ bool BethYw::is_number(const std::string& s)
   @param areasFilter
     An unordered set of areas to filter, or empty to import all areas
 
+  @param filter
+    The filters compiled into a FilterSpec, of which only the areas are used
+
+  @param stats
+    The RunStats to add an "areas" phase to, or nullptr
+
   @return
     void
 
@@ -488,17 +755,33 @@ bool BethYw::is_number(const std::string& s)
     const BethYw::SourceColumnMapping &cols
 */
 void BethYw::loadAreas(Areas& areas,std::string dir,std::unordered_set<std::string> areasFilter){
+  loadAreas(areas, dir, FilterSpec(&areasFilter, nullptr, nullptr));
+}
+
+void BethYw::loadAreas(Areas& areas,
+                       std::string dir,
+                       const FilterSpec& filter,
+                       RunStats* stats){
+  BETHYW_TRACE_SCOPE("BethYw::loadAreas");
+  RunStats::Timer timer(stats, "areas");
+  const RunStats::Counters before = stats ? countContents(areas)
+                                          : RunStats::Counters();
+  const ImportCounts rowsBefore = areas.getImportCounts();
 
   dir = dir+"areas.csv";
-  InputFile input(dir);
-  std::istream &stream = input.open();
+  MappedInputFile input(dir);
 
   // we can do this because we know this function will only read the areas.csv file
   SourceDataType datatype = AuthorityCodeCSV;
 
-  areas.populate(stream,datatype,BethYw::InputFiles::AREAS.COLS);
-  
+  const std::string_view data = input.open();
+  areas.populate(data,datatype,BethYw::InputFiles::AREAS.COLS,filter);
 
+  if(stats){
+    setCreated(timer.counters(), before, countContents(areas));
+    timer.counters().bytesRead = data.size();
+    setRows(timer.counters(), rowsBefore, areas.getImportCounts());
+  }
 }
 
 /*
@@ -508,12 +791,18 @@ void BethYw::loadAreas(Areas& areas,std::string dir,std::unordered_set<std::stri
                              areasFilter,
                              measuresFilter,
                              yearsFilter)
+        BethYw::loadDatasets(areas, dir, datasetsToImport, filter, threads,
+                             stats)
 
   Import datasets from `datasetsToImport` as files in `dir` into areas, and
   filtering them with the `areasFilter`, `measuresFilter`, and `yearsFilter`.
 
   The actual filtering will be done by the Areas::populate() function, thus 
-  you need to merely pass pointers on to these flters.
+  you need to merely pass pointers on to these flters. The filters are
+  compiled into a FilterSpec once, which is shared by every dataset.
+
+  Each file is memory-mapped with MappedInputFile and parsed in place. Datasets
+  can be parsed in parallel, see the threads parameter.
 
   This function should promise not to throw an exception. If there is an
   error/exception thrown in any function called by thus function, catch it and
@@ -541,8 +830,26 @@ void BethYw::loadAreas(Areas& areas,std::string dir,std::unordered_set<std::stri
     An two-pair tuple of unsigned ints corresponding to the range of years 
     to import, which should both be 0 to import all years.
 
+  @param filter
+    The three filters already compiled into a FilterSpec, for the overload
+    that takes one instead
+
+  @param threads
+    The number of threads to import with. With more than one thread, each
+    dataset is parsed into its own Areas on a ThreadPool and the results are
+    merged into areas in the order of datasetsToImport, so the data imported
+    is the same as when loading one dataset at a time. If there are more
+    threads than datasets, the spare threads are shared out to parse within
+    each JSON dataset.
+
+  @param stats
+    The RunStats to add phases to, or nullptr. There is a "datasets/<code>"
+    phase for parsing each dataset (with the Areas, Measures and values it
+    created before being merged), and a "datasets" phase for the whole import
+    (with those left after merging).
+
   @return
-    void
+    true if every dataset was imported, or false if any failed
 
   @example
     Areas areas();
@@ -553,31 +860,429 @@ void BethYw::loadAreas(Areas& areas,std::string dir,std::unordered_set<std::stri
       BethYw::parseDatasetsArgument(args),
       BethYw::parseAreasArg(args),
       BethYw::parseMeasuresArg(args),
-      BethYw::parseYearsArg(args));
+      BethYw::parseYearsArg(args),
+      BethYw::parseThreadsArg(args));
 */
-void BethYw::loadDatasets(
+bool BethYw::loadDatasets(
       Areas &areas,
       std::string dir,
       const std::vector<BethYw::InputFileSource> datasetsToImport,
       StringFilterSet areasFilter,
       StringFilterSet measuresFilter,
-      YearFilterTuple yearsFilter){
-        for(auto const & x :datasetsToImport){
-          std::string temp = dir;
-          temp = temp+x.FILE;
+      YearFilterTuple yearsFilter,
+      unsigned int threads){
+  return loadDatasets(areas, dir, datasetsToImport,
+                      FilterSpec(&areasFilter, &measuresFilter, &yearsFilter),
+                      threads);
+}
 
-          InputFile input(temp);
-          std::istream &stream = input.open();
+bool BethYw::loadDatasets(
+      Areas &areas,
+      std::string dir,
+      const std::vector<BethYw::InputFileSource> datasetsToImport,
+      const FilterSpec &filter,
+      unsigned int threads,
+      RunStats* stats){
+  BETHYW_TRACE_SCOPE("BethYw::loadDatasets");
+  RunStats::Timer timer(stats, "datasets");
+  const RunStats::Counters before = stats ? countContents(areas)
+                                          : RunStats::Counters();
+  const ImportCounts rowsBefore = areas.getImportCounts();
+  std::atomic<std::uint64_t> bytesRead{0};
+
+  // Threads not needed for one dataset each are used within the datasets
+  const unsigned int threadsPerDataset = std::max<std::size_t>(
+      1, threads / std::max<std::size_t>(1, datasetsToImport.size()));
+
+  // Each dataset is parsed into its own Areas, so datasets never share state.
+  // Loaded in turn, these allocate from the memory of areas, so merging moves
+  // their nodes across; loaded in parallel, each has its own arena instead
+  auto importDataset = [&](const BethYw::InputFileSource& source,
+                           bool parallel) {
+    BETHYW_TRACE_SCOPE("BethYw::importDataset", source.CODE);
+    RunStats::Timer datasetTimer(stats, "datasets/" + source.CODE);
+    MappedInputFile input(dir + source.FILE);
+    Areas partial = parallel ? Areas(Areas::Arena) : Areas(areas.getResource());
+    const std::string_view data = input.open();
+    partial.populate(data, source.PARSER, source.COLS, filter,
+                     threadsPerDataset);
+    if(stats){
+      datasetTimer.counters() = countContents(partial);
+      datasetTimer.counters().bytesRead = data.size();
+      setRows(datasetTimer.counters(), ImportCounts(), partial.getImportCounts());
+      bytesRead += data.size();
+    }
+    return partial;
+  };
+
+  // Fill in the "datasets" phase from what was merged into areas
+  auto countImport = [&]() {
+    if(stats){
+      setCreated(timer.counters(), before, countContents(areas));
+      timer.counters().bytesRead = bytesRead;
+      setRows(timer.counters(), rowsBefore, areas.getImportCounts());
+    }
+  };
+
+  bool allImported = true;
+  if(threads <= 1 || datasetsToImport.size() <= 1){
+    for(auto const& x : datasetsToImport){
+      try{
+        areas.merge(importDataset(x, false));
+      }catch(const std::exception& e){
+        std::cerr << "Error importing dataset:" << std::endl
+                  << e.what() << std::endl;
+        allImported = false;
+      }
+    }
+    countImport();
+    return allImported;
+  }
+
+  std::vector<std::future<Areas>> partials;
+  partials.reserve(datasetsToImport.size());
+  {
+    ThreadPool pool(std::min<std::size_t>(threads, datasetsToImport.size()));
+    for(auto const& x : datasetsToImport){
+      partials.push_back(pool.submit([&importDataset, &x]() {
+        return importDataset(x, true);
+      }));
+    }
+
+    // Merge in the order the datasets were given, so the result is the same
+    // as loading them one after another
+    for(auto& partial : partials){
+      try{
+        areas.merge(partial.get());
+      }catch(const std::exception& e){
+        std::cerr << "Error importing dataset:" << std::endl
+                  << e.what() << std::endl;
+        allImported = false;
+      }
+    }
+  }
+  countImport();
+  return allImported;
+}
 
-          std::string filename = x.FILE;
+/*
+  BethYw::snapshotPath(cacheDir,
+                       dir,
+                       datasetsToImport,
+                       areasFilter,
+                       measuresFilter,
+                       yearsFilter)
 
-          std::unordered_map<BethYw::SourceColumn, std::string> map;
-          for(auto const&y:x.COLS){
-            map.emplace(y.first, y.second);
-          }
+  Work out the filename of the snapshot for a particular import. The name is
+  a hash of the absolute data directory, the datasets and the filters, so
+  each different import has its own snapshot in cacheDir.
 
-          areas.populate(stream,x.PARSER,map,
-          &areasFilter,&measuresFilter,&yearsFilter);
+  @param cacheDir
+    The directory that snapshots are kept in
 
-        }
+  @param dir
+    The directory where the datasets are
+
+  @param datasetsToImport
+    A vector of InputFileSource objects
+
+  @param areasFilter
+    The areas filter, as passed to loadDatasets()
+
+  @param measuresFilter
+    The measures filter, as passed to loadDatasets()
+
+  @param yearsFilter
+    The years filter, as passed to loadDatasets()
+
+  @return
+    The path of the snapshot file, which may not exist yet
+
+  @example
+    std::string snapshotFile = BethYw::snapshotPath(
+      "cache", "datasets/", datasetsToImport, areasFilter, measuresFilter,
+      yearsFilter);
+*/
+std::string BethYw::snapshotPath(
+    const std::string& cacheDir,
+    const std::string& dir,
+    const std::vector<BethYw::InputFileSource>& datasetsToImport,
+    const StringFilterSet& areasFilter,
+    const StringFilterSet& measuresFilter,
+    const YearFilterTuple& yearsFilter){
+  std::error_code error;
+  std::filesystem::path absoluteDir = std::filesystem::absolute(dir, error);
+
+  // the order of filters in an unordered_set varies, so sort them first
+  std::vector<std::string> areas(areasFilter.begin(), areasFilter.end());
+  std::vector<std::string> measures(measuresFilter.begin(), measuresFilter.end());
+  std::sort(areas.begin(), areas.end());
+  std::sort(measures.begin(), measures.end());
+
+  std::string key = (error ? dir : absoluteDir.string()) + '\0';
+  key += std::to_string(Snapshot::VERSION) + '\0';
+  for(auto const& x : datasetsToImport){
+    key += x.FILE + ',';
+  }
+  key += '\0';
+  for(auto const& x : areas){
+    key += x + ',';
+  }
+  key += '\0';
+  for(auto const& x : measures){
+    key += x + ',';
+  }
+  key += '\0' + std::to_string(std::get<0>(yearsFilter)) + '-'
+              + std::to_string(std::get<1>(yearsFilter));
+
+  // 64-bit FNV-1a, which unlike std::hash gives the same name on every run
+  std::uint64_t hash = 14695981039346656037ull;
+  for(unsigned char c : key){
+    hash = (hash ^ c) * 1099511628211ull;
+  }
+
+  std::ostringstream filename;
+  filename << "bethyw-" << std::hex << std::setw(16) << std::setfill('0')
+           << hash << ".snapshot";
+  return (std::filesystem::path(cacheDir) / filename.str()).string();
+}
+
+/*
+  BethYw::loadSnapshot(areas, snapshotFile, dir, datasetsToImport)
+
+  Load a snapshot saved by saveSnapshot() into areas, if it is newer than
+  areas.csv and every dataset file. The snapshot is memory-mapped with
+  MappedInputFile.
+
+  A snapshot that is missing, out of date or unreadable is ignored, and areas
+  is left unchanged.
+
+  @param areas
+    An Areas instance to load the snapshot into
+
+  @param snapshotFile
+    The path of the snapshot, from snapshotPath()
+
+  @param dir
+    The directory where the datasets are
+
+  @param datasetsToImport
+    The datasets the snapshot was made from
+
+  @return
+    true if the snapshot was loaded, or false if the datasets must be imported
+
+  @example
+    if(!BethYw::loadSnapshot(areas, snapshotFile, dir, datasetsToImport)){
+      BethYw::loadAreas(areas, dir, areasFilter);
+      ...
+    }
+*/
+bool BethYw::loadSnapshot(
+    Areas& areas,
+    const std::string& snapshotFile,
+    const std::string& dir,
+    const std::vector<BethYw::InputFileSource>& datasetsToImport){
+  std::error_code error;
+  const auto snapshotTime = std::filesystem::last_write_time(snapshotFile, error);
+  if(error){
+    return false;
+  }
+
+  std::vector<std::string> sources{dir + InputFiles::AREAS.FILE};
+  for(auto const& x : datasetsToImport){
+    sources.push_back(dir + x.FILE);
+  }
+  for(auto const& source : sources){
+    const auto sourceTime = std::filesystem::last_write_time(source, error);
+    if(error || sourceTime >= snapshotTime){
+      return false;
+    }
+  }
+
+  try{
+    MappedInputFile input(snapshotFile);
+    Areas cached = Areas();
+    Snapshot::read(input.open(), cached);
+    areas.merge(std::move(cached));
+  }catch(const std::exception&){
+    return false;
+  }
+  return true;
+}
+
+/*
+  BethYw::saveSnapshot(areas, snapshotFile)
+
+  Save areas as a snapshot for later runs to load with loadSnapshot(). The
+  snapshot is written to a temporary file which is then renamed, so another
+  run never sees a partly written snapshot. Failing to save a snapshot is
+  reported but is not an error, as the data has already been imported.
+
+  @param areas
+    The Areas instance to save
+
+  @param snapshotFile
+    The path of the snapshot, from snapshotPath()
+
+  @example
+    BethYw::saveSnapshot(areas, snapshotFile);
+*/
+void BethYw::saveSnapshot(const Areas& areas, const std::string& snapshotFile){
+  const std::filesystem::path path(snapshotFile);
+  const std::filesystem::path temp = path.string() + ".tmp" + std::to_string(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  try{
+    std::filesystem::create_directories(path.parent_path());
+    {
+      std::ofstream file(temp, std::ios::binary);
+      if(!file){
+        throw std::runtime_error("Failed to create " + temp.string());
+      }
+      Snapshot::write(file, areas);
+    }
+    std::filesystem::rename(temp, path);
+  }catch(const std::exception& e){
+    std::error_code error;
+    std::filesystem::remove(temp, error);
+    std::cerr << "Error saving snapshot:" << std::endl
+              << e.what() << std::endl;
+  }
+}
+
+/*
+  BethYw::saveTrace(traceFile)
+
+  Write the spans recorded since Trace::start() to a file as Chrome trace
+  event JSON, for the --trace argument. Failing to save the trace is
+  reported but is not an error, as the output has already been printed.
+
+  @param traceFile
+    The path of the file to write
+
+  @example
+    Trace::start();
+    ...
+    Trace::stop();
+    BethYw::saveTrace("bethyw.trace.json");
+*/
+void BethYw::saveTrace(const std::string& traceFile){
+  std::ofstream file(traceFile, std::ios::binary);
+  if(!file){
+    std::cerr << "Error saving trace:" << std::endl
+              << "Failed to create " << traceFile << std::endl;
+    return;
+  }
+  Trace::writeChromeJSON(file);
+}
+
+/*
+  BethYw::serve(socketPath, dir, datasetsToImport, filter, threads, clients,
+                stats)
+
+  Load areas.csv and each dataset into its own Areas, and answer queries on
+  them with a QueryServer listening on a Unix domain socket, for the --serve
+  argument. See server.h for the protocol.
+
+  The filters given on the command line limit what is loaded, and so what
+  can be queried. A dataset that fails to import is reported, and cannot be
+  queried.
+
+  The server is stopped by SIGINT or SIGTERM, which close the connections,
+  remove the socket file and return, so that run() can still save the trace
+  and write the stats. The previous handlers are restored on return.
+
+  @param socketPath
+    The path of the socket to create
+
+  @param dir
+    The directory where the datasets are
+
+  @param datasetsToImport
+    The datasets to load
+
+  @param filter
+    The filters to load the datasets with
+
+  @param threads
+    The number of threads to import each dataset with
+
+  @param clients
+    The number of clients to answer at once
+
+  @param stats
+    The RunStats to record the loading and serving phases in, or nullptr
+
+  @return
+    Exit code
+
+  @throws
+    std::runtime_error if the socket cannot be created
+
+  @example
+    BethYw::serve("/tmp/bethyw.sock", "datasets/", datasetsToImport,
+                  FilterSpec(), 1, 4);
+*/
+int BethYw::serve(const std::string& socketPath,
+                  const std::string& dir,
+                  const std::vector<BethYw::InputFileSource>& datasetsToImport,
+                  const FilterSpec& filter,
+                  unsigned int threads,
+                  unsigned int clients,
+                  RunStats* stats){
+  Areas names(Areas::Arena);
+  loadAreas(names, dir, filter, stats);
+  QueryServer server(std::move(names));
+
+  // each dataset is kept apart, so queries can choose between them
+  for(auto const& x : datasetsToImport){
+    Areas data(Areas::Arena);
+    if(loadDatasets(data, dir, {x}, filter, threads, stats)){
+      server.addDataset(x, std::move(data));
+    }
+  }
+
+  RunStats::Timer timer(stats, "serve");
+#ifdef _WIN32
+  std::cerr << "Serving queries on " << socketPath << std::endl;
+  server.serve(socketPath, clients);
+#else
+  if(::pipe(stopPipe) != 0){
+    throw std::runtime_error("BethYw::serve: Failed to create a pipe");
+  }
+  struct sigaction action{};
+  action.sa_handler = stopServing;
+  sigemptyset(&action.sa_mask);
+  struct sigaction previousInt{};
+  struct sigaction previousTerm{};
+  ::sigaction(SIGINT, &action, &previousInt);
+  ::sigaction(SIGTERM, &action, &previousTerm);
+
+  // waits for a byte from the handler, or from below once serving is over
+  std::thread stopper([&server]() {
+    char byte;
+    while(::read(stopPipe[0], &byte, 1) < 0 && errno == EINTR){}
+    server.stop();
+  });
+  auto finish = [&stopper, &previousInt, &previousTerm]() {
+    stopServing(0);
+    stopper.join();
+    ::sigaction(SIGINT, &previousInt, nullptr);
+    ::sigaction(SIGTERM, &previousTerm, nullptr);
+    ::close(stopPipe[0]);
+    ::close(stopPipe[1]);
+    stopPipe[0] = stopPipe[1] = -1;
+  };
+
+  try{
+    std::cerr << "Serving queries on " << socketPath << std::endl;
+    server.serve(socketPath, clients);
+  }catch(...){
+    finish();
+    throw;
+  }
+  finish();
+  std::cerr << "Stopped serving queries on " << socketPath << std::endl;
+#endif
+  return 0;
 }
@@ -23,6 +23,8 @@
 
 #include "datasets.h"
 #include "areas.h"
+#include "filter.h"
+#include "runstats.h"
 
 const char DIR_SEP =
 #ifdef _WIN32
@@ -67,14 +69,78 @@ std::unordered_set<std::string> parseMeasuresArg(cxxopts::ParseResult& args);
 
 std::tuple<int,int> parseYearsArg(cxxopts::ParseResult& args);
 
+/*
+  Parse the threads argument and return the number of threads to import the
+  datasets with.
+*/
+unsigned int parseThreadsArg(cxxopts::ParseResult& args);
+
+/*
+  Parse the stats argument and return the format to print the statistics of
+  the run in, or an empty string if they are not wanted.
+*/
+std::string parseStatsArg(cxxopts::ParseResult& args);
+
 bool is_number(const std::string& s);
 void loadAreas(Areas& areas,std::string dir,std::unordered_set<std::string> areasFilter);
-void loadDatasets(Areas& areas,
+void loadAreas(Areas& areas,
+      std::string dir,
+      const FilterSpec& filter,
+      RunStats* stats = nullptr);
+bool loadDatasets(Areas& areas,
       std::string dir,
       std::vector<BethYw::InputFileSource> datasetsToImport,
       StringFilterSet areasFilter,
       StringFilterSet measuresFilter,
-      YearFilterTuple yearsFilter);
+      YearFilterTuple yearsFilter,
+      unsigned int threads = 1);
+bool loadDatasets(Areas& areas,
+      std::string dir,
+      std::vector<BethYw::InputFileSource> datasetsToImport,
+      const FilterSpec& filter,
+      unsigned int threads = 1,
+      RunStats* stats = nullptr);
+
+/*
+  Count the Areas, Measures and values in an Areas instance, for the --stats
+  argument.
+*/
+RunStats::Counters countContents(const Areas& areas);
+
+/*
+  Work out where the snapshot of a particular import is kept, and load or save
+  it. See snapshot.h for the snapshot format.
+*/
+std::string snapshotPath(
+      const std::string& cacheDir,
+      const std::string& dir,
+      const std::vector<BethYw::InputFileSource>& datasetsToImport,
+      const StringFilterSet& areasFilter,
+      const StringFilterSet& measuresFilter,
+      const YearFilterTuple& yearsFilter);
+bool loadSnapshot(Areas& areas,
+      const std::string& snapshotFile,
+      const std::string& dir,
+      const std::vector<BethYw::InputFileSource>& datasetsToImport);
+void saveSnapshot(const Areas& areas, const std::string& snapshotFile);
+
+/*
+  Save the spans recorded by Trace to a file for the --trace argument. See
+  trace.h.
+*/
+void saveTrace(const std::string& traceFile);
+
+/*
+  Load the datasets once and answer queries on them over a Unix domain
+  socket until SIGINT or SIGTERM, for the --serve argument. See server.h.
+*/
+int serve(const std::string& socketPath,
+      const std::string& dir,
+      const std::vector<BethYw::InputFileSource>& datasetsToImport,
+      const FilterSpec& filter,
+      unsigned int threads,
+      unsigned int clients,
+      RunStats* stats = nullptr);
 //tuple parseYearsArg(args);
 
 } // namespace BethYw
@@ -2,14 +2,38 @@
 
 SET bin_dir=bin
 SET tests_dir=tests
-SET source_files=bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp
+SET bench_dir=bench
+SET source_files=bethyw.cpp input.cpp csv.cpp threadpool.cpp snapshot.cpp symbol.cpp filter.cpp runstats.cpp trace.cpp server.cpp stats.cpp areas.cpp area.cpp measure.cpp
 SET main_file=main.cpp
 SET executable=%bin_dir%\bethyw.exe
+SET optimisation=
 
 COPY bin\bethyw2.exe bin\bethyw.exe
 
 IF "%1"=="" GOTO compile
 
+IF "%1"=="avx2" (
+  SET executable=%bin_dir%\bethyw-avx2.exe
+  SET optimisation=-O2 -DNDEBUG -mavx2
+  GOTO compile
+)
+
+IF "%1"=="bench-avx2" (
+  SET source_files=%source_files% %bench_dir%\generator.cpp %bench_dir%\bench.cpp
+  SET main_file=
+  SET executable=%bin_dir%\bethyw-bench-avx2.exe
+  SET optimisation=-O2 -DNDEBUG -DBETHYW_COUNT_ALLOCATIONS -mavx2
+  GOTO compile
+)
+
+IF "%1"=="bench" (
+  SET source_files=%source_files% %bench_dir%\generator.cpp %bench_dir%\bench.cpp
+  SET main_file=
+  SET executable=%bin_dir%\bethyw-bench.exe
+  SET optimisation=-O2 -DNDEBUG -DBETHYW_COUNT_ALLOCATIONS
+  GOTO compile
+)
+
 SET testStr=%1%
 SET testStr=%testStr:~0,4%
 IF %testStr%==test (
@@ -25,6 +49,11 @@ IF %testStr%==test (
 :compile
 IF NOT EXIST %bin_dir% MKDIR %bin_dir%
 IF EXIST %executable% DEL %executable%
-g++ --std=c++14 -Wall %source_files% %main_file% -o %executable%
+REM Extra compiler flags can be given in CXXFLAGS, e.g. to compile in tracing
+REM and allocation counting:
+REM   SET CXXFLAGS=-DBETHYW_TRACE -DBETHYW_COUNT_ALLOCATIONS
+REM or to run a test against the AVX2 statistics kernels:
+REM   SET CXXFLAGS=-mavx2
+g++ --std=c++17 -Wall -pthread %optimisation% %CXXFLAGS% %source_files% %main_file% -o %executable%
 
 :end
@@ -2,18 +2,36 @@
 
 BIN_DIR="bin"
 TESTS_DIR="tests"
-SOURCE_FILES="bethyw.cpp input.cpp areas.cpp area.cpp measure.cpp"
+BENCH_DIR="bench"
+SOURCE_FILES="bethyw.cpp input.cpp csv.cpp threadpool.cpp snapshot.cpp symbol.cpp filter.cpp runstats.cpp trace.cpp server.cpp stats.cpp areas.cpp area.cpp measure.cpp"
 MAIN_FILE="main.cpp"
 EXECUTABLE="./${BIN_DIR}/bethyw"
+OPTIMISATION=""
 
 set -x
 cd "${0%/*}"
 
 if [ $# -gt 1 ]; then
-  echo "Unknown arguments!" "Only one argument accepted, and must begin with test"
+  echo "Unknown arguments!" "Only one argument accepted, either avx2, bench, bench-avx2 or beginning with test"
   exit
 elif [ $# -eq 1 ]; then
-  if [[ $1 == test* ]]; then
+  if [[ $1 == avx2 ]]; then
+    # An optimised build for processors with AVX2, which uses the AVX2
+    # statistics kernels in stats.cpp instead of the SSE2 ones
+    EXECUTABLE="./${BIN_DIR}/bethyw-avx2"
+    OPTIMISATION="-O2 -DNDEBUG -mavx2"
+  elif [[ $1 == bench || $1 == bench-avx2 ]]; then
+    # The benchmarks are built with optimisations, like a release build, and
+    # count heap allocations
+    SOURCE_FILES="${SOURCE_FILES} ./${BENCH_DIR}/generator.cpp ./${BENCH_DIR}/bench.cpp"
+    MAIN_FILE=""
+    EXECUTABLE="./${BIN_DIR}/bethyw-bench"
+    OPTIMISATION="-O2 -DNDEBUG -DBETHYW_COUNT_ALLOCATIONS"
+    if [[ $1 == bench-avx2 ]]; then
+      EXECUTABLE="./${BIN_DIR}/bethyw-bench-avx2"
+      OPTIMISATION="${OPTIMISATION} -mavx2"
+    fi
+  elif [[ $1 == test* ]]; then
     SOURCE_FILES="${SOURCE_FILES} ./${TESTS_DIR}/$1.cpp"
     MAIN_FILE="./${BIN_DIR}/catch.o"
     EXECUTABLE="./${BIN_DIR}/bethyw-test"
@@ -27,4 +45,9 @@ fi
 
 mkdir -p ${BIN_DIR}
 rm ${EXECUTABLE} 2> /dev/null
-g++ --std=c++14 -pedantic -Wall ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE}
\ No newline at end of file
+# Extra compiler flags can be given in CXXFLAGS, e.g. to compile in tracing
+# and allocation counting:
+#   CXXFLAGS="-DBETHYW_TRACE -DBETHYW_COUNT_ALLOCATIONS" ./build.sh
+# or to run a test against the AVX2 statistics kernels:
+#   CXXFLAGS=-mavx2 ./build.sh test19
+g++ --std=c++17 -pedantic -Wall -pthread ${OPTIMISATION} ${CXXFLAGS} ${SOURCE_FILES} ${MAIN_FILE} -o ${EXECUTABLE}
\ No newline at end of file
@@ -0,0 +1,209 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the CSVReader class. See the header
+  file for additional comments.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "csv.h"
+
+/*
+  CSVReader::CSVReader(data)
+  CSVReader::CSVReader(is)
+
+  Construct a reader over CSV data that is already in memory, or over an input
+  stream. No data is read until nextRow() is called.
+
+  @param data
+    The CSV data, which must outlive the reader
+
+  @param is
+    The input stream to read the CSV data from
+
+  @example
+    MappedInputFile input("data/areas.csv");
+    CSVReader reader(input.open());
+*/
+CSVReader::CSVReader(std::string_view data) : data(data) {}
+
+CSVReader::CSVReader(std::istream& is) : stream(&is) {}
+
+/*
+  CSVReader::nextRow()
+
+  Read the next non-blank row and split it into fields, which can then be
+  retrieved with fields().
+
+  @return
+    true if a row was read, or false if there are no more rows
+
+  @throws
+    std::runtime_error if a quoted field is not terminated, or is followed by
+    anything other than a comma or the end of the row
+
+  @example
+    CSVReader reader(input.open());
+    while(reader.nextRow()){
+      for(std::string_view field : reader.fields()){
+        ...
+      }
+    }
+*/
+bool CSVReader::nextRow(){
+  std::string_view record;
+  while(readRecord(record)){
+    if(!record.empty()){
+      tokenize(record);
+      return true;
+    }
+  }
+  rowFields.clear();
+  return false;
+}
+
+/*
+  CSVReader::fields()
+
+  @return
+    The fields of the row read by the last call to nextRow(). The views are
+    invalidated by the next call to nextRow().
+*/
+const std::vector<std::string_view>& CSVReader::fields() const noexcept{
+  return rowFields;
+}
+
+/*
+  CSVReader::getRowNumber()
+
+  @return
+    The 1-based number of the current row, counting blank rows, for use in
+    error messages
+*/
+std::size_t CSVReader::getRowNumber() const noexcept{
+  return rowNumber;
+}
+
+// Reads the next record (which can span several lines if a quoted field
+// contains a line break) without its line ending. Returns false at the end
+// of the input.
+bool CSVReader::readRecord(std::string_view& record){
+  rowNumber++;
+  if(stream != nullptr){
+    if(!std::getline(*stream, rowBuffer)){
+      return false;
+    }
+    // an odd number of quotes means a quoted field runs onto the next line
+    std::string line;
+    while(std::count(rowBuffer.begin(), rowBuffer.end(), '"') % 2 != 0){
+      if(!std::getline(*stream, line)){
+        throw std::runtime_error("CSVReader: Unterminated quoted field on row "
+                                 + std::to_string(rowNumber));
+      }
+      rowBuffer += '\n';
+      rowBuffer += line;
+    }
+    record = rowBuffer;
+  }else{
+    if(position >= data.size()){
+      return false;
+    }
+    std::size_t end = position;
+    bool inQuotes = false;
+    while(true){
+      std::size_t newline = data.find('\n', end);
+      std::size_t stop = newline == std::string_view::npos ? data.size()
+                                                           : newline;
+      if(std::count(data.begin() + end, data.begin() + stop, '"') % 2 != 0){
+        inQuotes = !inQuotes;
+      }
+      if(!inQuotes || newline == std::string_view::npos){
+        end = stop;
+        break;
+      }
+      end = newline + 1;
+    }
+    if(inQuotes){
+      throw std::runtime_error("CSVReader: Unterminated quoted field on row "
+                               + std::to_string(rowNumber));
+    }
+    record = data.substr(position, end - position);
+    position = end + 1;
+  }
+  if(!record.empty() && record.back() == '\r'){
+    record.remove_suffix(1);
+  }
+  return true;
+}
+
+// Splits a record into rowFields. Quoted fields point inside the quotes,
+// unless they contain escaped quotes, in which case they are unescaped into
+// a buffer reserved up front so that earlier views are not invalidated.
+void CSVReader::tokenize(std::string_view record){
+  rowFields.clear();
+  unescaped.clear();
+  unescaped.reserve(record.size());
+
+  const std::size_t length = record.size();
+  std::size_t i = 0;
+  while(true){
+    std::string_view field;
+    if(i < length && record[i] == '"'){
+      std::size_t start = i + 1;
+      std::size_t search = start;
+      bool escaped = false;
+      while(true){
+        std::size_t quote = record.find('"', search);
+        if(quote == std::string_view::npos){
+          throw std::runtime_error("CSVReader: Unterminated quoted field on row "
+                                   + std::to_string(rowNumber));
+        }
+        if(quote + 1 < length && record[quote + 1] == '"'){
+          escaped = true;
+          search = quote + 2;
+          continue;
+        }
+        field = record.substr(start, quote - start);
+        i = quote + 1;
+        break;
+      }
+      if(escaped){
+        std::size_t begin = unescaped.size();
+        for(std::size_t k = 0; k < field.size(); k++){
+          unescaped += field[k];
+          if(field[k] == '"'){
+            k++;
+          }
+        }
+        field = std::string_view(unescaped.data() + begin,
+                                 unescaped.size() - begin);
+      }
+      if(i < length && record[i] != ','){
+        throw std::runtime_error(
+            "CSVReader: Unexpected character after quoted field on row "
+            + std::to_string(rowNumber));
+      }
+    }else{
+      std::size_t comma = record.find(',', i);
+      std::size_t stop = comma == std::string_view::npos ? length : comma;
+      field = record.substr(i, stop - i);
+      i = stop;
+    }
+    rowFields.push_back(field);
+    if(i >= length){
+      break;
+    }
+    // skip the comma; a trailing comma gives one more, empty, field
+    i++;
+  }
+}
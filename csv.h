@@ -0,0 +1,55 @@
+#ifndef CSV_H_
+#define CSV_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the declaration of the CSVReader class, a single-pass
+  tokenizer shared by the CSV parsers in Areas.
+ */
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+  CSVReader splits comma-separated values into rows of fields, one row at a
+  time. Each field is handed out as a std::string_view, so no strings are
+  allocated per field.
+
+  When reading from a std::string_view (e.g. a MappedInputFile), fields point
+  straight into that data. When reading from a std::istream, only the current
+  row is buffered. Either way, the views returned by fields() are only valid
+  until the next call to nextRow().
+
+  Fields may be wrapped in double quotes, in which case they can contain
+  commas, line breaks and escaped ("") quotes. Blank lines are skipped and
+  Windows line endings are accepted.
+*/
+class CSVReader {
+  private:
+    std::istream* stream = nullptr;
+    std::string_view data;
+    std::size_t position = 0;
+    std::size_t rowNumber = 0;
+    std::string rowBuffer;
+    std::string unescaped;
+    std::vector<std::string_view> rowFields;
+
+    bool readRecord(std::string_view& record);
+    void tokenize(std::string_view record);
+public:
+  CSVReader(std::string_view data);
+  CSVReader(std::istream& is);
+  bool nextRow();
+  const std::vector<std::string_view>& fields() const noexcept;
+  std::size_t getRowNumber() const noexcept;
+};
+
+#endif // CSV_H_
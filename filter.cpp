@@ -0,0 +1,93 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the FilterSpec class. See the
+  header file for additional comments.
+*/
+
+#include "filter.h"
+
+/*
+  FilterSpec::FilterSpec(areasFilter, measuresFilter, yearsFilter)
+
+  Compile the filters of an import. A null or empty set, or a year range of
+  <0,0>, does not filter anything.
+
+  @param areasFilter
+    The local authority codes to import, or nullptr
+
+  @param measuresFilter
+    The lowercase measure codenames to import, or nullptr
+
+  @param yearsFilter
+    The first and last years to import, inclusive, or nullptr
+
+  @example
+    StringFilterSet areasFilter = {"W06000011"};
+    YearFilterTuple yearsFilter(2010, 2015);
+    FilterSpec filter(&areasFilter, nullptr, &yearsFilter);
+    filter.accepts("W06000011", "pop", 2012); // true
+    filter.accepts("W06000011", "pop", 2016); // false
+*/
+FilterSpec::FilterSpec(const StringFilterSet * const areasFilter,
+                       const StringFilterSet * const measuresFilter,
+                       const YearFilterTuple * const yearsFilter) {
+  if(areasFilter != nullptr){
+    areas = TextSet(*areasFilter);
+  }
+  if(measuresFilter != nullptr){
+    measures = TextSet(*measuresFilter);
+  }
+
+  if(yearsFilter != nullptr){
+    const int start = (int) std::get<0>(*yearsFilter);
+    const int end = (int) std::get<1>(*yearsFilter);
+    if(start != 0 || end != 0){
+      filteringYears = true;
+      firstYear = static_cast<std::uint32_t>(start);
+      yearSpan = static_cast<std::uint32_t>(end) - firstYear;
+      yearsAccepted = start <= end;
+    }
+  }
+}
+
+/*
+  FilterSpec::TextSet::TextSet(strings)
+
+  Build a hash table of some strings, with at least twice as many slots as
+  strings. Each string is placed in the first empty slot at or after the one
+  its hash picks.
+
+  @param strings
+    The strings in the set
+*/
+FilterSpec::TextSet::TextSet(const StringFilterSet& strings)
+    : members(strings.begin(), strings.end()) {
+  if(members.empty()){
+    return;
+  }
+
+  std::size_t size = 2;
+  while(size < members.size() * 2){
+    size *= 2;
+  }
+  slots.assign(size, 0);
+  mask = size - 1;
+
+  hashes.reserve(members.size());
+  for(std::size_t i = 0; i < members.size(); i++){
+    hashes.push_back(hash(members[i]));
+    std::size_t slot = hashes[i] & mask;
+    while(slots[slot] != 0){
+      slot = (slot + 1) & mask;
+    }
+    slots[slot] = static_cast<std::uint32_t>(i + 1);
+  }
+}
@@ -0,0 +1,150 @@
+#ifndef FILTER_H_
+#define FILTER_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the FilterSpec class, the area, measure and year filters
+  of an import compiled into a form that is cheap to check for every row.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
+#include <vector>
+
+/*
+  An alias for filters based on strings such as categorisations e.g. area,
+  and measures.
+*/
+using StringFilterSet = std::unordered_set<std::string>;
+
+/*
+  An alias for a year filter.
+*/
+using YearFilterTuple = std::tuple<unsigned int, unsigned int>;
+
+/*
+  A FilterSpec is built once from the filters given on the command line, and
+  then shared by every populate function, which checks each row against it
+  before doing any other work on the row.
+
+  The area and measure filters are each compiled into an open-addressing hash
+  table with linear probing, at most half full, that keeps the hash of each
+  string. Checking some text hashes it once and only compares it with a
+  string whose hash is the same, and building the table takes time linear in
+  the size of the filter. An empty filter accepts everything without hashing.
+
+  The tables hold text rather than Symbols, as rows are filtered before
+  anything is interned: finding a row's Symbol would hash its text anyway,
+  and would add the codes of rejected rows to the symbol table.
+
+  The year filter is compiled into a first year and a span, so that checking
+  a year is a single unsigned comparison.
+
+  @example
+    auto areasFilter = BethYw::parseAreasArg(args);
+    auto measuresFilter = BethYw::parseMeasuresArg(args);
+    auto yearsFilter = BethYw::parseYearsArg(args);
+    FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+
+    if(filter.accepts("W06000011", "pop", 2015)){
+      ...
+    }
+*/
+class FilterSpec {
+  private:
+    class TextSet {
+      private:
+        std::vector<std::string> members;
+        std::vector<std::uint64_t> hashes;
+        std::vector<std::uint32_t> slots;
+        std::size_t mask = 0;
+
+        // a 64-bit FNV-1a hash, with the high bits folded into the low bits
+        // that pick the slot
+        static std::uint64_t hash(std::string_view text) noexcept {
+          std::uint64_t hash = 14695981039346656037ull;
+          for(const char c : text){
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 1099511628211ull;
+          }
+          return hash ^ (hash >> 32);
+        }
+      public:
+        TextSet() = default;
+        explicit TextSet(const StringFilterSet& strings);
+
+        bool empty() const noexcept {
+          return members.empty();
+        }
+
+        // the table is never full, so the probe always reaches an empty slot
+        bool contains(std::string_view text) const noexcept {
+          const std::uint64_t textHash = hash(text);
+          for(std::size_t i = textHash & mask; ; i = (i + 1) & mask){
+            const std::uint32_t slot = slots[i];
+            if(slot == 0){
+              return false;
+            }
+            if(hashes[slot - 1] == textHash && members[slot - 1] == text){
+              return true;
+            }
+          }
+        }
+    };
+
+    TextSet areas;
+    TextSet measures;
+    std::uint32_t firstYear = 0;
+    std::uint32_t yearSpan = UINT32_MAX;
+    bool filteringYears = false;
+    // false if the year range is empty, so that no year is accepted
+    bool yearsAccepted = true;
+  public:
+    FilterSpec() = default;
+    FilterSpec(const StringFilterSet * const areasFilter,
+               const StringFilterSet * const measuresFilter,
+               const YearFilterTuple * const yearsFilter);
+
+    bool filtersAreas() const noexcept {
+      return !areas.empty();
+    }
+
+    bool filtersMeasures() const noexcept {
+      return !measures.empty();
+    }
+
+    bool filtersYears() const noexcept {
+      return filteringYears;
+    }
+
+    bool acceptsArea(std::string_view localAuthorityCode) const noexcept {
+      return areas.empty() || areas.contains(localAuthorityCode);
+    }
+
+    // the codename must already be lowercase
+    bool acceptsMeasure(std::string_view codename) const noexcept {
+      return measures.empty() || measures.contains(codename);
+    }
+
+    bool acceptsYear(int year) const noexcept {
+      return yearsAccepted & (static_cast<std::uint32_t>(year) - firstYear <= yearSpan);
+    }
+
+    bool accepts(std::string_view localAuthorityCode,
+                 std::string_view codename,
+                 int year) const noexcept {
+      return acceptsYear(year) && acceptsArea(localAuthorityCode) &&
+             acceptsMeasure(codename);
+    }
+};
+
+#endif // FILTER_H_
@@ -18,11 +18,21 @@
  */
 
 #include "input.h"
+#include "trace.h"
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <stdio.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 /*
   TODO: InputSource::InputSource(source)
 
@@ -80,6 +90,7 @@ InputFile::InputFile(const std::string& filePath) : InputSource(filePath) {
     input.open();
 */
 std::ifstream& InputFile::open(){
+  BETHYW_TRACE_SCOPE("InputFile::open", this->getSource());
   fileContents.open(this->getSource());
   if(!fileContents.is_open()){
     throw std::runtime_error("InputFile::open: Failed to open file "+ this->getSource());
@@ -88,3 +99,95 @@ std::ifstream& InputFile::open(){
   }  
 }
 
+/*
+  MappedInputFile::MappedInputFile(path)
+
+  Constructor for a memory-mapped file source. The file is not opened until
+  open() is called.
+
+  @param path
+    The complete path for a file to import.
+
+  @example
+    MappedInputFile input("data/popu1009.json");
+*/
+MappedInputFile::MappedInputFile(const std::string& filePath)
+    : InputSource(filePath) {}
+
+/*
+  MappedInputFile::~MappedInputFile()
+
+  Unmap the file, invalidating any view returned by open().
+*/
+MappedInputFile::~MappedInputFile(){
+#ifndef _WIN32
+  if(mappedData != nullptr){
+    munmap(const_cast<char*>(mappedData), mappedLength);
+  }
+#endif
+}
+
+/*
+  MappedInputFile::open()
+
+  Map the file at the path retrievable from getSource() into memory and return
+  a view over its contents. Calling open() again returns the same view. An
+  empty file gives an empty view.
+
+  @return
+    A std::string_view over the bytes of the file
+
+  @throws
+    std::runtime_error if there is an issue opening or mapping the file (or
+    the path is not a regular file, e.g. a directory), with the same message
+    as InputFile::open():
+    InputFile::open: Failed to open file <file name>
+
+  @example
+    MappedInputFile input("data/popu1009.json");
+    std::string_view data = input.open();
+*/
+std::string_view MappedInputFile::open(){
+  if(mappedData != nullptr){
+    return std::string_view(mappedData, mappedLength);
+  }
+  BETHYW_TRACE_SCOPE("MappedInputFile::open", this->getSource());
+  const std::string failure =
+      "InputFile::open: Failed to open file " + this->getSource();
+#ifdef _WIN32
+  std::ifstream file(this->getSource(), std::ios::binary);
+  if(!file.is_open()){
+    throw std::runtime_error(failure);
+  }
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  fileContents = contents.str();
+  mappedData = fileContents.data();
+  mappedLength = fileContents.size();
+#else
+  int fd = ::open(this->getSource().c_str(), O_RDONLY);
+  if(fd < 0){
+    throw std::runtime_error(failure);
+  }
+  struct stat info;
+  if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+    ::close(fd);
+    throw std::runtime_error(failure);
+  }
+  mappedLength = static_cast<std::size_t>(info.st_size);
+  if(mappedLength == 0){
+    ::close(fd);
+    return std::string_view();
+  }
+  void* address = mmap(nullptr, mappedLength, PROT_READ, MAP_PRIVATE, fd, 0);
+  // the mapping keeps its own reference to the file
+  ::close(fd);
+  if(address == MAP_FAILED){
+    mappedLength = 0;
+    throw std::runtime_error(failure);
+  }
+  madvise(address, mappedLength, MADV_SEQUENTIAL);
+  mappedData = static_cast<const char*>(address);
+#endif
+  return std::string_view(mappedData, mappedLength);
+}
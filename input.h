@@ -9,9 +9,11 @@
   AUTHOR: 958804
 
   This file contains declarations for the input source handlers. There are
-  two classes: InputSource and InputFile. InputSource is abstract (i.e. it
-  contains a pure virtual function). InputFile is a concrete derivation of
-  InputSource, for input from files.
+  three classes: InputSource, InputFile and MappedInputFile. InputSource is
+  abstract (i.e. it contains a pure virtual function). InputFile is a concrete
+  derivation of InputSource, for input from files as a stream, and
+  MappedInputFile is one that memory-maps a file and exposes its bytes
+  directly.
 
   Although only one class derives from InputSource, we have implemented our
   code this way to support future expansion of input from different sources
@@ -21,7 +23,9 @@
   functions and member variables you need to declare in these classes.
  */
 
+#include <cstddef>
 #include <string>
+#include <string_view>
 #include <fstream>
 
 /*
@@ -61,4 +65,28 @@ public:
   std::ifstream& open();
 };
 
+/*
+  Source data that is contained within a file, which is memory-mapped rather
+  than read through a stream. open() returns a view over the whole file, which
+  stays valid until the MappedInputFile is destroyed, so parsers can work on
+  the bytes in place without any copying or iostream overhead.
+
+  On platforms without mmap (i.e. Windows), the file is read into memory once
+  instead.
+*/
+class MappedInputFile : public InputSource {
+  private:
+    const char* mappedData = nullptr;
+    std::size_t mappedLength = 0;
+#ifdef _WIN32
+    std::string fileContents;
+#endif
+public:
+  MappedInputFile(const std::string& filePath);
+  MappedInputFile(const MappedInputFile& other) = delete;
+  MappedInputFile& operator=(const MappedInputFile& other) = delete;
+  ~MappedInputFile();
+  std::string_view open();
+};
+
 #endif // INPUT_H_
\ No newline at end of file
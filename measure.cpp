@@ -20,8 +20,10 @@
 
 #include <stdexcept>
 #include <string>
+#include <algorithm>
+#include <charconv>
 #include <iostream>
-#include <iomanip>
+#include <string_view>
 #include "measure.h"
 
 /*
@@ -38,14 +40,109 @@
   @param label
     Human-readable (i.e. nice/explanatory) label for the measure
 
+  @param alloc
+    The allocator for the values, which is the default memory resource unless
+    the Measure is being created inside a std::pmr container
+
+  The codename and label are interned as Symbols. The parsers, which see the
+  same codenames and labels on every row, pass Symbols from a SymbolCache to
+  the overload taking Symbols instead.
+
   @example
     std::string codename = "Pop";
     std::string label = "Population";
     Measure measure(codename, label);
 */
-Measure::Measure(std::string codename, const std::string &label) {
-  this->codename = codename;
-  this->label = label;
+Measure::Measure(std::string codename,
+                 const std::string &label,
+                 const allocator_type& alloc)
+    : Measure(Symbol(codename), Symbol(label), alloc) {}
+
+Measure::Measure(Symbol codename, Symbol label, const allocator_type& alloc)
+    : codename(codename), label(label), yearValues(alloc), presentMask(alloc) {}
+
+/*
+  Measure::Measure(other)
+  Measure::operator=(other)
+
+  Move a Measure, taking over its values. The other Measure is left with no
+  values, so its statistics are those of an empty Measure rather than of the
+  values that were moved out of it.
+
+  @param other
+    The Measure to move
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    Measure moved(std::move(measure)); // measure.size() is now 0
+*/
+Measure::Measure(Measure&& other) noexcept
+    : codename(other.codename),
+      label(other.label),
+      firstYear(other.firstYear),
+      yearValues(std::move(other.yearValues)),
+      presentMask(std::move(other.presentMask)),
+      count(other.count),
+      sum(other.sum),
+      minValue(other.minValue),
+      maxValue(other.maxValue) {
+  other.reset();
+}
+
+Measure& Measure::operator=(Measure&& other){
+  if(this != &other){
+    codename = other.codename;
+    label = other.label;
+    firstYear = other.firstYear;
+    yearValues = std::move(other.yearValues);
+    presentMask = std::move(other.presentMask);
+    count = other.count;
+    sum = other.sum;
+    minValue = other.minValue;
+    maxValue = other.maxValue;
+    other.reset();
+  }
+  return *this;
+}
+
+/*
+  Measure::Measure(other, alloc)
+
+  Copy or move a Measure into storage from another allocator, as a std::pmr
+  container does when a Measure is inserted into it. Moving only takes over
+  the other Measure's buffers if both use the same memory resource; otherwise
+  the values are copied. Either way, a Measure that is moved from is left
+  with no values.
+
+  @param other
+    The Measure to copy or move
+
+  @param alloc
+    The allocator for the new Measure's values
+*/
+Measure::Measure(const Measure& other, const allocator_type& alloc)
+    : codename(other.codename),
+      label(other.label),
+      firstYear(other.firstYear),
+      yearValues(other.yearValues, alloc),
+      presentMask(other.presentMask, alloc),
+      count(other.count),
+      sum(other.sum),
+      minValue(other.minValue),
+      maxValue(other.maxValue) {}
+
+Measure::Measure(Measure&& other, const allocator_type& alloc)
+    : codename(other.codename),
+      label(other.label),
+      firstYear(other.firstYear),
+      yearValues(std::move(other.yearValues), alloc),
+      presentMask(std::move(other.presentMask), alloc),
+      count(other.count),
+      sum(other.sum),
+      minValue(other.minValue),
+      maxValue(other.maxValue) {
+  other.reset();
 }
 
 /*
@@ -67,7 +164,7 @@ Measure::Measure(std::string codename, const std::string &label) {
     ...
     auto codename2 = measure.getCodename();
 */
-std::string Measure::getCodename(){
+const std::string& Measure::getCodename() const noexcept{
   return this->codename;
 }
 
@@ -90,14 +187,34 @@ std::string Measure::getCodename(){
     ...
     auto label = measure.getLabel();
 */
-std::string Measure::getLabel(){
+const std::string& Measure::getLabel() const noexcept{
+  return this->label;
+}
+
+/*
+  Measure::getCodenameSymbol()
+  Measure::getLabelSymbol()
+
+  Retrieve the codename or label as the Symbol the Measure holds, for
+  building another Measure with the same codename or label without
+  interning it again.
+
+  @return
+    The Symbol of the codename or label
+*/
+Symbol Measure::getCodenameSymbol() const noexcept{
+  return this->codename;
+}
+
+Symbol Measure::getLabelSymbol() const noexcept{
   return this->label;
 }
 
 /*
   TODO: Measure::setLabel(label)
 
-  Change the label for the Measure.
+  Change the label for the Measure. A label given as a string is interned as
+  a Symbol.
 
   @param label
     The new label for the Measure
@@ -109,6 +226,10 @@ std::string Measure::getLabel(){
     measure.setLabel("New Population");
 */
 void Measure::setLabel(std::string label){
+  this->label = Symbol(label);
+}
+
+void Measure::setLabel(Symbol label){
   this->label = label;
 }
 
@@ -139,12 +260,14 @@ void Measure::setLabel(std::string label){
     ...
     auto value = measure.getValue(1999); // returns 12345678.9
 */
-double Measure::getValue(int key){
-  if(values.count(key) > 0){
-    return values.find(key)->second;
-  }else{
-    throw std::out_of_range("No value found for year "+std::to_string(key));
+double Measure::getValue(int key) const{
+  // the slot is worked out once, for both the presence check and the read
+  const long long index = (long long) key - firstYear;
+  if(index >= 0 && index < (long long) yearValues.size() &&
+     ((presentMask[index / 64] >> (index % 64)) & 1)){
+    return yearValues[index];
   }
+  throw std::out_of_range("No value found for year "+std::to_string(key));
 }
 
 /*
@@ -162,6 +285,12 @@ double Measure::getValue(int key){
   @return
     void
 
+  @throws
+    std::out_of_range if the year is more than MAX_YEAR_SPAN years from the
+    other years of the Measure, with the message:
+    Year <year> is too far from the other years of <codename>
+    The Measure is unchanged if this is thrown.
+
   @example
     std::string codename = "Pop";
     std::string label = "Population";
@@ -171,19 +300,192 @@ double Measure::getValue(int key){
 */
 
 void Measure::setValue(int key, double value){
-  if(values.count(key) > 0){
-    values.erase(key);
+  makeRoomFor(key);
+  const std::size_t index = key - firstYear;
+  const std::uint64_t bit = std::uint64_t(1) << (index % 64);
+
+  // A new year only widens the aggregates, in whatever order years arrive
+  if((presentMask[index / 64] & bit) == 0){
+    presentMask[index / 64] |= bit;
+    yearValues[index] = value;
+    count++;
+    sum += value;
+    minValue = count == 1 ? value : std::min(minValue, value);
+    maxValue = count == 1 ? value : std::max(maxValue, value);
+    return;
+  }
+
+  // Replacing a value swaps it in the sum. The values only need to be looked
+  // at again if the one replaced was the minimum or maximum and the new one
+  // does not take its place.
+  const double old = yearValues[index];
+  yearValues[index] = value;
+  sum += value - old;
+  bool rescan = false;
+  if(value <= minValue){
+    minValue = value;
+  }else if(old == minValue){
+    rescan = true;
+  }
+  if(value >= maxValue){
+    maxValue = value;
+  }else if(old == maxValue){
+    rescan = true;
+  }
+  if(rescan){
+    Stats::minMax(yearValues.data(), presentMask.data(), yearValues.size(),
+                  minValue, maxValue);
+  }
+}
+
+/*
+  Measure::merge(other)
+
+  Copy every year's value from another Measure into this one, replacing any
+  value this Measure already has for the same year. The codename and label of
+  this Measure are kept. If this Measure has no values yet, the rvalue
+  overload takes over the other Measure's storage instead of copying it.
+
+  @param other
+    The Measure whose values should be merged into this one
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+
+    Measure update("pop", "Population");
+    update.setValue(2000, 12345679.9);
+
+    measure.merge(std::move(update)); // measure has values for 1999 and 2000
+*/
+void Measure::merge(const Measure& other){
+  for(const auto& x : other){
+    setValue(x.first, x.second);
+  }
+}
+
+void Measure::merge(Measure&& other){
+  if(count == 0){
+    firstYear = other.firstYear;
+    yearValues = std::move(other.yearValues);
+    presentMask = std::move(other.presentMask);
+    count = other.count;
+    sum = other.sum;
+    minValue = other.minValue;
+    maxValue = other.maxValue;
+    other.reset();
+  }else{
+    merge(static_cast<const Measure&>(other));
+  }
+}
+
+// recalculates the sum, minimum and maximum from the stored values, which
+// is only needed after accumulate() has changed many of them at once
+void Measure::recomputeAggregates(){
+  // absent years hold 0, so every slot can be summed
+  sum = Stats::sum(yearValues.data(), yearValues.size());
+  Stats::minMax(yearValues.data(), presentMask.data(), yearValues.size(),
+                minValue, maxValue);
+}
+
+// removes every value, leaving the codename and label, as when a Measure has
+// been moved from
+void Measure::reset() noexcept{
+  yearValues.clear();
+  presentMask.clear();
+  firstYear = 0;
+  count = 0;
+  sum = minValue = maxValue = 0;
+}
+
+// returns true if a value has been set for the given year
+bool Measure::hasYear(int year) const{
+  const long long index = (long long) year - firstYear;
+  if(index < 0 || index >= (long long) yearValues.size()){
+    return false;
+  }
+  return (presentMask[index / 64] >> (index % 64)) & 1;
+}
+
+// throws std::out_of_range if storing the years from fromYear to toYear
+// alongside the current ones would take more than MAX_YEAR_SPAN slots. The
+// span is worked out in long long, as the difference of two ints can
+// overflow an int.
+void Measure::checkSpan(int fromYear, int toYear) const{
+  long long first = fromYear;
+  long long last = toYear;
+  if(!yearValues.empty()){
+    first = std::min(first, (long long) firstYear);
+    last = std::max(last, (long long) firstYear + (long long) yearValues.size() - 1);
+  }
+  if(last - first + 1 > MAX_YEAR_SPAN){
+    const int year = fromYear < firstYear ? fromYear : toYear;
+    throw std::out_of_range("Year " + std::to_string(year) +
+                            " is too far from the other years of " +
+                            codename.string());
   }
-    values.emplace(key, value);
-  
 }
 
-std::map<int, double> Measure::getAll(){
-  std::map<int, double> map;
-  for (auto const& x : this->values){
-    map.emplace(x.first,x.second);
+// grows the dense storage so that it has a slot for year, shifting the
+// existing values up if year comes before the current first year
+void Measure::makeRoomFor(int year){
+  if(yearValues.empty()){
+    firstYear = year;
+    yearValues.assign(1, 0);
+    presentMask.assign(1, 0);
+    return;
   }
-  return map;
+  checkSpan(year, year);
+  if(year < firstYear){
+    std::size_t shift = firstYear - year;
+    std::pmr::vector<std::uint64_t> oldMask(std::move(presentMask));
+    yearValues.insert(yearValues.begin(), shift, 0);
+    presentMask.assign(yearValues.size() / 64 + 1, 0);
+    for(std::size_t i = 0; i + shift < yearValues.size(); i++){
+      if((oldMask[i / 64] >> (i % 64)) & 1){
+        std::size_t j = i + shift;
+        presentMask[j / 64] |= std::uint64_t(1) << (j % 64);
+      }
+    }
+    firstYear = year;
+  }else if((std::size_t) (year - firstYear) >= yearValues.size()){
+    yearValues.resize(year - firstYear + 1, 0);
+    presentMask.resize(yearValues.size() / 64 + 1, 0);
+  }
+}
+
+/*
+  Measure::getAll()
+
+  Copy every year and value into a new std::map. Prefer iterating over the
+  Measure itself with begin()/end(), which reads the values in place.
+
+  @return
+    A std::map of years to values
+*/
+std::map<int, double> Measure::getAll() const{
+  return std::map<int, double>(begin(), end());
+}
+
+/*
+  Measure::begin() / Measure::end()
+
+  Iterate over the (year, value) pairs of this Measure in chronological order
+  without copying them.
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    for(const auto& yearValue : measure){
+      ...
+    }
+*/
+Measure::const_iterator Measure::begin() const{
+  return const_iterator(this, 0);
+}
+
+Measure::const_iterator Measure::end() const{
+  return const_iterator(this, yearValues.size());
 }
 /*
   TODO: Measure::size()
@@ -203,8 +505,60 @@ std::map<int, double> Measure::getAll(){
     measure.setValue(1999, 12345678.9);
     auto size = measure.size(); // returns 1
 */
-int Measure::size(){
-  return this->values.size();
+int Measure::size() const{
+  return this->count;
+}
+
+/*
+  Measure::getFirstYear()
+  Measure::getLastYear()
+
+  Retrieve the first and last years that have a value.
+
+  @return
+    The earliest or latest year with a value, or 0 if there are no values
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 12345678.9);
+    measure.setValue(2001, 12345679.9);
+    auto first = measure.getFirstYear(); // returns 1999
+*/
+int Measure::getFirstYear() const noexcept{
+  return count == 0 ? 0 : firstYear;
+}
+
+int Measure::getLastYear() const noexcept{
+  return count == 0 ? 0 : firstYear + (int) yearValues.size() - 1;
+}
+
+/*
+  Measure::getSum()
+  Measure::getMin()
+  Measure::getMax()
+
+  Retrieve the sum, smallest and largest of the values. These are kept up to
+  date by setValue(), so they take constant time.
+
+  @return
+    The sum, minimum or maximum value, or 0 if there are no values
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 10);
+    measure.setValue(2001, 20);
+    auto max = measure.getMax(); // returns 20
+*/
+double Measure::getSum() const noexcept{
+  return sum;
+}
+
+double Measure::getMin() const noexcept{
+  return minValue;
+}
+
+double Measure::getMax() const noexcept{
+  return maxValue;
 }
 
 /*
@@ -224,9 +578,14 @@ int Measure::size(){
     measure.setValue(2001, 12345679.9);
     auto diff = measure.getDifference(); // returns 1.0
 */
-double Measure::getDifference(){
-  double first = values.begin()->second;
-  double last = values.end()->second;
+double Measure::getDifference() const{
+  if(count == 0){
+    return 0;
+  }
+  // absent slots never sit at either end of the dense storage, as it only
+  // grows to fit a year that is being set
+  double first = yearValues.front();
+  double last = yearValues.back();
   return last-first;
 }
 
@@ -238,8 +597,9 @@ double Measure::getDifference(){
   must promise to not change the state of the instance or throw an exception.
 
   @return
-    The difference/change in value from the first to the last year as a decminal
-    value, or 0 if it cannot be calculated
+    The difference/change in value from the first to the last year as a
+    percentage of the first year's value (e.g. 10.0 for a rise of 10%), or 0 if
+    it cannot be calculated
 
   @example
     Measure measure("pop", "Population");
@@ -247,13 +607,16 @@ double Measure::getDifference(){
     measure.setValue(2010, 12345679.9);
     auto diff = measure.getDifferenceAsPercentage();
 */
-double Measure::getDifferenceAsPercentage(){
-  double denominator = values.begin()->second;
+double Measure::getDifferenceAsPercentage() const{
+  if(count == 0){
+    return 0;
+  }
+  double denominator = yearValues.front();
   double difference = this->getDifference();
   if(denominator ==  0 || difference == 0){
     return 0;
   }
-  return difference/denominator;
+  return difference/denominator*100;
 }
 
 /*
@@ -263,6 +626,9 @@ double Measure::getDifferenceAsPercentage(){
   callable from a constant context and must promise to not change the state of 
   the instance or throw an exception.
 
+  The sum of the values is kept up to date by setValue(), so this takes
+  constant time.
+
   @return
     The average value for all the years, or 0 if it cannot be calculated
 
@@ -272,15 +638,125 @@ double Measure::getDifferenceAsPercentage(){
     measure.setValue(2001, 12345679.9);
     auto diff = measure.getDifference(); // returns 1
 */
-double Measure::getAverage(){
-  int size = values.size();
-  double rollingTotal = 0;
-  for(auto const& x: values){
-    rollingTotal = rollingTotal + x.second;
+double Measure::getAverage() const{
+  if(count == 0){
+    return 0;
+  }
+  return sum/count;
+}
+
+/*
+  Measure::getVariance()
+
+  Calculate the (population) variance of the values across all years.
+
+  @return
+    The variance of the values, or 0 if there are none
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 1);
+    measure.setValue(2001, 3);
+    auto variance = measure.getVariance(); // returns 1
+*/
+double Measure::getVariance() const{
+  if(count == 0){
+    return 0;
+  }
+  return Stats::sumSquaredDeviations(yearValues.data(), presentMask.data(),
+                                     yearValues.size(), getAverage()) / count;
+}
+
+/*
+  Measure::getSummary()
+
+  Gather the count, sum, minimum, maximum, average and variance of the values
+  into a Stats::Summary, which can be combined with those of other Measures
+  using Stats::combine().
+
+  @return
+    The Summary of the values across all years
+
+  @example
+    Measure measure("pop", "Population");
+    measure.setValue(1999, 1);
+    measure.setValue(2001, 3);
+    auto summary = measure.getSummary(); // summary.mean is 2
+*/
+Stats::Summary Measure::getSummary() const{
+  Stats::Summary summary;
+  summary.count = count;
+  summary.sum = sum;
+  summary.min = minValue;
+  summary.max = maxValue;
+  summary.mean = getAverage();
+  summary.variance = getVariance();
+  return summary;
+}
+
+/*
+  Measure::accumulate(other)
+
+  Add another Measure's value for each year to this Measure's value for the
+  same year, treating a year without a value as 0. This is used to total a
+  measure across areas. The codename and label of this Measure are kept.
+
+  @param other
+    The Measure whose values should be added to this one
+
+  @example
+    Measure total("pop", "Population");
+    total.setValue(1999, 1);
+
+    Measure other("pop", "Population");
+    other.setValue(1999, 2);
+    other.setValue(2000, 3);
+
+    total.accumulate(other); // total has 3 for 1999 and 3 for 2000
+*/
+void Measure::accumulate(const Measure& other){
+  if(other.count == 0){
+    return;
+  }
+  // checked up front, so the storage is not grown at one end and then found
+  // to be too wide at the other
+  checkSpan(other.firstYear, other.getLastYear());
+  makeRoomFor(other.firstYear);
+  makeRoomFor(other.getLastYear());
+
+  const std::size_t offset = other.firstYear - firstYear;
+  Stats::addInto(yearValues.data() + offset, other.yearValues.data(),
+                 other.yearValues.size());
+
+  // the other Measure's presence bits, shifted along by offset
+  for(std::size_t word = 0; word < other.presentMask.size(); word++){
+    const std::uint64_t bits = other.presentMask[word];
+    const std::size_t index = offset + word * 64;
+    if(bits == 0){
+      continue;
+    }
+    presentMask[index / 64] |= bits << (index % 64);
+    if(index % 64 != 0 && index / 64 + 1 < presentMask.size()){
+      presentMask[index / 64 + 1] |= bits >> (64 - index % 64);
     }
-  return rollingTotal/size;
+  }
+
+  count = std::distance(begin(), end());
+  recomputeAggregates();
+}
+
+namespace {
+
+// Appends a value with six decimal places, as std::fixed does by default
+void appendFixed(std::string& out, double value) {
+  char buffer[400]; // enough for the largest double in full
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value,
+                              std::chars_format::fixed, 6);
+  out.append(buffer, result.ptr);
 }
 
+} // namespace
+
 /*
   TODO: operator<<(os, measure)
 
@@ -300,6 +776,15 @@ double Measure::getAverage(){
 
   See the coursework specification for more information.
 
+  Values are formatted with std::to_chars rather than through the stream, so
+  the output does not depend on the stream's locale or flags, and every cell
+  is formatted once, into buffers that are reused between Measures. For
+  example:
+
+    Population density (dens) 
+         1991      1992      1993   Average    Diff.  % Diff. 
+    97.126504 97.486216 98.038430 97.550383 0.911926 0.938905 
+
   @param os
     The output stream to write to
 
@@ -317,24 +802,65 @@ double Measure::getAverage(){
     measure.setValue(1999, 12345678.9);
     std::cout << measure << std::end;
 */
-std::ostream& operator<<(std::ostream &os, Measure measure){
-  auto values = measure.getAll();
-  os<<measure.getLabel()<<" ("<<measure.getCodename()<<")\n";
-  //column headers for output
-  for(const auto& x: values){
-    os<<std::setw(10);
-    os<<(x.first);
+std::ostream& operator<<(std::ostream &os, const Measure& measure){
+  // Every cell of the table is formatted into these buffers once, and they
+  // are reused for the next Measure so that no memory is allocated per value
+  thread_local std::string headers;
+  thread_local std::string values;
+  thread_local std::vector<std::size_t> headerEnds;
+  thread_local std::vector<std::size_t> valueEnds;
+  thread_local std::string out;
+  headers.clear();
+  values.clear();
+  headerEnds.clear();
+  valueEnds.clear();
+  out.clear();
+
+  out += measure.getLabel();
+  out += " (";
+  out += measure.getCodename();
+  out += ") \n";
+
+  if(measure.size() == 0){
+    out += "<no data>\n";
+    os.write(out.data(), out.size());
+    return os;
   }
-  os<<("Average")<<std::setw(10)<<("Diff.")<<std::setw(10)<<("%Diff.\n");
-  //values for output
-  for(const auto& x: values){
-    os<<std::setw(10);
-    os<<(x.second);
+
+  auto addColumn = [](std::string_view header, double value) {
+    headers += header;
+    headerEnds.push_back(headers.size());
+    appendFixed(values, value);
+    valueEnds.push_back(values.size());
+  };
+  char year[16];
+  for(const auto& x : measure){
+    auto result = std::to_chars(year, year + sizeof(year), x.first);
+    addColumn(std::string_view(year, result.ptr - year), x.second);
   }
-  os<<measure.getAverage()<<std::setw(10);
-  os<<measure.getDifference()<<std::setw(10);
-  os<<measure.getDifferenceAsPercentage()<<std::setw(10);
-  os<<"\n";
+  addColumn("Average", measure.getAverage());
+  addColumn("Diff.", measure.getDifference());
+  addColumn("% Diff.", measure.getDifferenceAsPercentage());
+
+  // Each column is as wide as the longer of its header and value, with the
+  // header and value right-aligned and followed by a space
+  for(int row = 0; row < 2; row++){
+    const std::string& cells = row == 0 ? headers : values;
+    const std::vector<std::size_t>& ends = row == 0 ? headerEnds : valueEnds;
+    std::size_t start = 0;
+    for(std::size_t i = 0; i < ends.size(); i++){
+      const std::size_t headerLength = headerEnds[i] - (i > 0 ? headerEnds[i - 1] : 0);
+      const std::size_t valueLength = valueEnds[i] - (i > 0 ? valueEnds[i - 1] : 0);
+      const std::size_t length = ends[i] - start;
+      out.append(std::max(headerLength, valueLength) - length, ' ');
+      out.append(cells, start, length);
+      out += ' ';
+      start = ends[i];
+    }
+    out += '\n';
+  }
+
+  os.write(out.data(), out.size());
   return os;
 }
 
@@ -356,8 +882,17 @@ std::ostream& operator<<(std::ostream &os, Measure measure){
 */
 
 bool operator==(const Measure& lhs, const Measure& rhs){
-    if(lhs.codename == rhs.codename && lhs.label == rhs.label && lhs.values == rhs.values){
-         return true;
+    if(lhs.codename != rhs.codename || lhs.label != rhs.label || lhs.count != rhs.count){
+      return false;
     }
-    return false;
+    // the dense storage of equal measures can start at different years, so
+    // compare year by year rather than the vectors themselves
+    for(std::size_t i = 0; i < lhs.yearValues.size(); i++){
+      int year = lhs.firstYear + (int) i;
+      if(lhs.hasYear(year) &&
+         (!rhs.hasYear(year) || rhs.yearValues[year - rhs.firstYear] != lhs.yearValues[i])){
+        return false;
+      }
+    }
+    return true;
 }
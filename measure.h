@@ -14,35 +14,159 @@
   functions and member variables you need to declare in this class.
  */
 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <utility>
 #include <string>
 #include <map>
+#include <memory_resource>
+#include <vector>
+
+#include "stats.h"
+#include "symbol.h"
 
 /*
   The Measure class contains a measure code, label, and a container for readings
   from across a number of years.
 
+  Readings are stored densely: yearValues holds one slot per year starting at
+  firstYear, and the matching bit in presentMask records whether that year has
+  a value. Years in the datasets form a small contiguous range, so this keeps
+  a measure in two small allocations instead of one tree node per year. So
+  that one bad year cannot make the storage huge, the years of a Measure must
+  all lie within MAX_YEAR_SPAN of each other.
+
+  The sum, minimum and maximum of the values are kept up to date as values
+  are set, so the statistics functions never have to walk the values.
+
+  Measure is allocator-aware: the value buffers come from the allocator it is
+  constructed with, and a std::pmr container of Measures passes its own
+  allocator down, so a Measure inside an Area allocates from the same memory
+  resource as the Area.
+
   TODO: Based on your implementation, there may be additional constructors
   or functions you implement here, and perhaps additional operators you may wish
   to overload.
 */
 class Measure {
   private:
-  std::string codename;
-  std::string label;
-  std::map <int, double> values;
+  Symbol codename;
+  Symbol label;
+  int firstYear = 0;
+  std::pmr::vector<double> yearValues;
+  std::pmr::vector<std::uint64_t> presentMask;
+  int count = 0;
+  double sum = 0;
+  double minValue = 0;
+  double maxValue = 0;
+
+  bool hasYear(int year) const;
+  void checkSpan(int fromYear, int toYear) const;
+  void makeRoomFor(int year);
+  void recomputeAggregates();
+  void reset() noexcept;
   public:
-    Measure(std::string code, const std::string &label);
-    std::string getCodename();
-    std::string getLabel();
+    /*
+      A read-only iterator over the years that have a value, in chronological
+      order. Dereferencing gives a (year, value) pair built from the dense
+      storage, so walking a Measure never copies its values into a new
+      container.
+    */
+    class const_iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<int, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = value_type;
+
+        const_iterator(const Measure* measure, std::size_t index)
+            : measure(measure), index(index) {
+          skipAbsent();
+        }
+
+        value_type operator*() const {
+          return value_type(measure->firstYear + (int) index,
+                            measure->yearValues[index]);
+        }
+
+        const_iterator& operator++() {
+          index++;
+          skipAbsent();
+          return *this;
+        }
+
+        const_iterator operator++(int) {
+          const_iterator previous = *this;
+          ++(*this);
+          return previous;
+        }
+
+        bool operator==(const const_iterator& other) const {
+          return index == other.index;
+        }
+
+        bool operator!=(const const_iterator& other) const {
+          return index != other.index;
+        }
+
+      private:
+        const Measure* measure;
+        std::size_t index;
+
+        void skipAbsent() {
+          index = Stats::nextPresent(measure->presentMask.data(),
+                                     measure->yearValues.size(), index);
+        }
+    };
+
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    /*
+      The most years, from the first to the last, that a Measure can hold.
+      This is enough for any two four-digit years.
+    */
+    static constexpr long long MAX_YEAR_SPAN = 10000;
+
+    Measure(std::string code,
+            const std::string &label,
+            const allocator_type& alloc = {});
+    Measure(Symbol codename,
+            Symbol label,
+            const allocator_type& alloc = {});
+    Measure(const Measure& other) = default;
+    Measure(Measure&& other) noexcept;
+    Measure(const Measure& other, const allocator_type& alloc);
+    Measure(Measure&& other, const allocator_type& alloc);
+    Measure& operator=(const Measure& other) = default;
+    Measure& operator=(Measure&& other);
+    const std::string& getCodename() const noexcept;
+    const std::string& getLabel() const noexcept;
+    Symbol getCodenameSymbol() const noexcept;
+    Symbol getLabelSymbol() const noexcept;
     void setLabel(std::string label);
-    double getValue(int key);
+    void setLabel(Symbol label);
+    double getValue(int key) const;
     void setValue(int key, double value);
-    std::map<int, double> getAll();
-    int size();
-    double getDifference();
-    double getDifferenceAsPercentage();
-    double getAverage();
-    friend std::ostream& operator<<(std::ostream& os,Measure measure);
+    void merge(const Measure& other);
+    void merge(Measure&& other);
+    std::map<int, double> getAll() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    int size() const;
+    int getFirstYear() const noexcept;
+    int getLastYear() const noexcept;
+    double getSum() const noexcept;
+    double getMin() const noexcept;
+    double getMax() const noexcept;
+    double getDifference() const;
+    double getDifferenceAsPercentage() const;
+    double getAverage() const;
+    double getVariance() const;
+    Stats::Summary getSummary() const;
+    void accumulate(const Measure& other);
+    friend std::ostream& operator<<(std::ostream& os, const Measure& measure);
     friend bool operator==(const Measure &lhs, const Measure &rhs);
 };
 
@@ -0,0 +1,479 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the RunStats class, and (in
+  builds with BETHYW_COUNT_ALLOCATIONS defined) the replacements for the
+  global operator new and delete that count the heap allocations it reports.
+  See the header file for additional comments.
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+#include <utility>
+
+#ifdef _WIN32
+#include <malloc.h>
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "lib_json.hpp"
+
+#include "runstats.h"
+
+using json = nlohmann::json;
+
+#ifdef BETHYW_COUNT_ALLOCATIONS
+
+/*
+  Every allocation made through the global operator new is counted. The array
+  and nothrow forms call these by default. As in the standard operator new,
+  the new handler is called until the allocation succeeds or there is no
+  handler left to call.
+
+  The replacements are never inlined, so GCC does not mistake a delete for a
+  free() of memory that came from new.
+*/
+#if defined(__GNUC__)
+#define RUNSTATS_NOINLINE __attribute__((noinline))
+#else
+#define RUNSTATS_NOINLINE
+#endif
+
+namespace {
+
+std::atomic<std::uint64_t> allocationCount{0};
+std::atomic<std::uint64_t> allocatedByteCount{0};
+
+// Calls the new handler after an allocation fails, or throws if there is none
+void handleAllocationFailure() {
+  std::new_handler handler = std::get_new_handler();
+  if(handler == nullptr){
+    throw std::bad_alloc();
+  }
+  handler();
+}
+
+} // namespace
+
+RUNSTATS_NOINLINE void* operator new(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocatedByteCount.fetch_add(size, std::memory_order_relaxed);
+  while(true){
+    if(void* ptr = std::malloc(size == 0 ? 1 : size)){
+      return ptr;
+    }
+    handleAllocationFailure();
+  }
+}
+
+RUNSTATS_NOINLINE void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+RUNSTATS_NOINLINE void operator delete(void* ptr, std::size_t) noexcept {
+  std::free(ptr);
+}
+
+// std::pmr::new_delete_resource() allocates with the aligned forms
+RUNSTATS_NOINLINE void* operator new(std::size_t size, std::align_val_t align) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  allocatedByteCount.fetch_add(size, std::memory_order_relaxed);
+  const std::size_t alignment = static_cast<std::size_t>(align);
+  while(true){
+#ifdef _WIN32
+    void* ptr = _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+    // aligned_alloc() needs the size to be a multiple of the alignment
+    const std::size_t rounded = (size + alignment - 1) / alignment * alignment;
+    void* ptr = std::aligned_alloc(alignment,
+                                   rounded == 0 ? alignment : rounded);
+#endif
+    if(ptr != nullptr){
+      return ptr;
+    }
+    handleAllocationFailure();
+  }
+}
+
+RUNSTATS_NOINLINE void operator delete(void* ptr, std::align_val_t) noexcept {
+#ifdef _WIN32
+  _aligned_free(ptr);
+#else
+  std::free(ptr);
+#endif
+}
+
+RUNSTATS_NOINLINE void operator delete(void* ptr,
+                                       std::size_t,
+                                       std::align_val_t align) noexcept {
+  operator delete(ptr, align);
+}
+
+#endif // BETHYW_COUNT_ALLOCATIONS
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(
+      std::chrono::steady_clock::now() - start).count();
+}
+
+json countersToJSON(const RunStats::Counters& counters) {
+  return json{{"bytes_read", counters.bytesRead},
+              {"rows_parsed", counters.rowsParsed},
+              {"rows_filtered", counters.rowsFiltered},
+              {"areas_created", counters.areasCreated},
+              {"measures_created", counters.measuresCreated},
+              {"values_created", counters.valuesCreated}};
+}
+
+// Allocations are null where they are not counted, rather than 0
+json phaseToJSON(const RunStats::Phase& phase) {
+  json allocations = nullptr;
+  json allocatedBytes = nullptr;
+  if(RunStats::COUNTS_ALLOCATIONS){
+    allocations = phase.allocations;
+    allocatedBytes = phase.allocatedBytes;
+  }
+  return json{{"name", phase.name},
+              {"wall_seconds", phase.wallSeconds},
+              {"cpu_seconds", phase.cpuSeconds},
+              {"allocations", allocations},
+              {"allocated_bytes", allocatedBytes},
+              {"peak_rss_bytes", phase.peakResidentBytes},
+              {"counters", countersToJSON(phase.counters)}};
+}
+
+void writeTextRow(std::ostream& os, const RunStats::Phase& phase) {
+  const auto& counters = phase.counters;
+  os << std::left << std::setw(24) << phase.name << std::right
+     << std::fixed << std::setprecision(2)
+     << std::setw(11) << phase.wallSeconds * 1000
+     << std::setw(11) << phase.cpuSeconds * 1000
+     << std::setprecision(1)
+     << std::setw(10) << counters.bytesRead / 1024.0
+     << std::setw(10) << counters.rowsParsed
+     << std::setw(10) << counters.rowsFiltered
+     << std::setw(8) << counters.areasCreated
+     << std::setw(10) << counters.measuresCreated
+     << std::setw(10) << counters.valuesCreated;
+  if(RunStats::COUNTS_ALLOCATIONS){
+    os << std::setw(10) << phase.allocations
+       << std::setw(12) << phase.allocatedBytes / 1024.0;
+  }else{
+    os << std::setw(10) << "-" << std::setw(12) << "-";
+  }
+  os << std::setw(14) << phase.peakResidentBytes / 1024.0
+     << '\n';
+}
+
+} // namespace
+
+/*
+  RunStats::Counters::operator+=(other)
+
+  Add another phase's counters to these.
+
+  @param other
+    The counters to add
+
+  @return
+    These counters
+*/
+RunStats::Counters& RunStats::Counters::operator+=(
+    const Counters& other) noexcept {
+  bytesRead += other.bytesRead;
+  rowsParsed += other.rowsParsed;
+  rowsFiltered += other.rowsFiltered;
+  areasCreated += other.areasCreated;
+  measuresCreated += other.measuresCreated;
+  valuesCreated += other.valuesCreated;
+  return *this;
+}
+
+/*
+  RunStats::Timer::Timer(stats, name)
+
+  Start timing a phase.
+
+  @param stats
+    The RunStats to add the phase to, or nullptr to record nothing
+
+  @param name
+    The name of the phase. Phases inside another phase are named after it,
+    e.g. "datasets/popden" inside "datasets", and are left out of the total.
+*/
+RunStats::Timer::Timer(RunStats* stats, std::string name)
+    : stats(stats),
+      wallStart(),
+      cpuStart(0),
+      allocationsStart(0),
+      allocatedBytesStart(0) {
+  if(stats == nullptr){
+    return;
+  }
+  phase.name = std::move(name);
+  wallStart = std::chrono::steady_clock::now();
+  cpuStart = RunStats::cpuSeconds();
+  allocationsStart = RunStats::allocations();
+  allocatedBytesStart = RunStats::allocatedBytes();
+}
+
+/*
+  RunStats::Timer::~Timer()
+
+  Stop timing the phase if stop() has not been called, including when the
+  phase ends with an exception.
+*/
+RunStats::Timer::~Timer() {
+  try{
+    stop();
+  } catch(const std::exception&){
+    // the phase is lost, but the run carries on
+  }
+}
+
+/*
+  RunStats::Timer::counters()
+
+  @return
+    The counters of the phase, to fill in before it is stopped
+*/
+RunStats::Counters& RunStats::Timer::counters() noexcept {
+  return phase.counters;
+}
+
+/*
+  RunStats::Timer::stop()
+
+  Stop timing the phase and add it to the RunStats. Does nothing if the phase
+  has already been stopped.
+*/
+void RunStats::Timer::stop() {
+  if(stats == nullptr){
+    return;
+  }
+  phase.wallSeconds = secondsSince(wallStart);
+  phase.cpuSeconds = RunStats::cpuSeconds() - cpuStart;
+  phase.allocations = RunStats::allocations() - allocationsStart;
+  phase.allocatedBytes = RunStats::allocatedBytes() - allocatedBytesStart;
+  phase.peakResidentBytes = RunStats::peakResidentBytes();
+
+  RunStats* const recordTo = stats;
+  stats = nullptr;
+  recordTo->addPhase(std::move(phase));
+}
+
+/*
+  RunStats::RunStats()
+
+  Construct a RunStats with no phases. The total is timed from here.
+*/
+RunStats::RunStats()
+    : wallStart(std::chrono::steady_clock::now()),
+      cpuStart(cpuSeconds()),
+      allocationsStart(allocations()),
+      allocatedBytesStart(allocatedBytes()) {}
+
+/*
+  RunStats::addPhase(phase)
+
+  Add a phase, which Timer does when it is stopped. Phases may be added from
+  several threads at once.
+
+  @param phase
+    The phase to add
+*/
+void RunStats::addPhase(Phase phase) {
+  std::lock_guard<std::mutex> lock(mutex);
+  phases.push_back(std::move(phase));
+}
+
+/*
+  RunStats::getPhases()
+
+  @return
+    A copy of the phases, in the order they finished
+*/
+std::vector<RunStats::Phase> RunStats::getPhases() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return phases;
+}
+
+/*
+  RunStats::getTotal()
+
+  @return
+    A phase named "total" covering the time since the RunStats was
+    constructed, with the counters of every top-level phase added together
+*/
+RunStats::Phase RunStats::getTotal() const {
+  Phase total;
+  total.name = "total";
+  total.wallSeconds = secondsSince(wallStart);
+  total.cpuSeconds = cpuSeconds() - cpuStart;
+  total.allocations = allocations() - allocationsStart;
+  total.allocatedBytes = allocatedBytes() - allocatedBytesStart;
+  total.peakResidentBytes = peakResidentBytes();
+  for(const auto& phase : getPhases()){
+    if(phase.name.find('/') == std::string::npos){
+      total.counters += phase.counters;
+    }
+  }
+  return total;
+}
+
+/*
+  RunStats::writeText(os)
+
+  Write the phases and the total as a table, one row per phase. Times are in
+  milliseconds and sizes in KiB.
+
+  @param os
+    The stream to write to
+
+  @example
+    stats.writeText(std::cerr);
+*/
+void RunStats::writeText(std::ostream& os) const {
+  const auto flags = os.flags();
+  const auto precision = os.precision();
+
+  os << std::left << std::setw(24) << "phase" << std::right
+     << std::setw(11) << "wall ms"
+     << std::setw(11) << "cpu ms"
+     << std::setw(10) << "read KiB"
+     << std::setw(10) << "rows"
+     << std::setw(10) << "filtered"
+     << std::setw(8) << "areas"
+     << std::setw(10) << "measures"
+     << std::setw(10) << "values"
+     << std::setw(10) << "allocs"
+     << std::setw(12) << "alloc KiB"
+     << std::setw(14) << "peak RSS KiB"
+     << '\n';
+  for(const auto& phase : getPhases()){
+    writeTextRow(os, phase);
+  }
+  writeTextRow(os, getTotal());
+
+  os.flags(flags);
+  os.precision(precision);
+}
+
+/*
+  RunStats::writeJSON(os)
+
+  Write the phases and the total as a JSON object, with times in seconds and
+  sizes in bytes.
+
+  @param os
+    The stream to write to
+
+  @example
+    stats.writeJSON(std::cerr);
+    // {"phases":[{"name":"arguments","wall_seconds":0.0001,...},...],
+    //  "total":{"name":"total",...}}
+*/
+void RunStats::writeJSON(std::ostream& os) const {
+  json output{{"phases", json::array()}};
+  for(const auto& phase : getPhases()){
+    output["phases"].push_back(phaseToJSON(phase));
+  }
+  output["total"] = phaseToJSON(getTotal());
+  os << output.dump() << '\n';
+}
+
+/*
+  RunStats::cpuSeconds()
+
+  @return
+    The user and system CPU time used by the process so far, in seconds
+*/
+double RunStats::cpuSeconds() noexcept {
+#ifdef _WIN32
+  FILETIME creation, exitTime, kernel, user;
+  if(!GetProcessTimes(GetCurrentProcess(), &creation, &exitTime, &kernel,
+                      &user)){
+    return 0;
+  }
+  auto ticks = [](const FILETIME& time) {
+    return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32)
+           | time.dwLowDateTime;
+  };
+  // FILETIME counts in 100ns intervals
+  return (ticks(kernel) + ticks(user)) / 1e7;
+#else
+  rusage usage{};
+  if(getrusage(RUSAGE_SELF, &usage) != 0){
+    return 0;
+  }
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6
+         + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec / 1e6;
+#endif
+}
+
+/*
+  RunStats::peakResidentBytes()
+
+  @return
+    The largest resident set size of the process so far, in bytes, or 0 where
+    it is not available
+*/
+std::uint64_t RunStats::peakResidentBytes() noexcept {
+#ifdef _WIN32
+  return 0;
+#else
+  rusage usage{};
+  if(getrusage(RUSAGE_SELF, &usage) != 0){
+    return 0;
+  }
+#ifdef __APPLE__
+  return static_cast<std::uint64_t>(usage.ru_maxrss);
+#else
+  // Linux and the BSDs give kilobytes
+  return static_cast<std::uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+}
+
+/*
+  RunStats::allocations()
+
+  @return
+    The number of allocations made through the global operator new so far,
+    or 0 if allocations are not counted in this build
+*/
+std::uint64_t RunStats::allocations() noexcept {
+#ifdef BETHYW_COUNT_ALLOCATIONS
+  return allocationCount.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
+
+/*
+  RunStats::allocatedBytes()
+
+  @return
+    The number of bytes requested from the global operator new so far, or 0
+    if allocations are not counted in this build
+*/
+std::uint64_t RunStats::allocatedBytes() noexcept {
+#ifdef BETHYW_COUNT_ALLOCATIONS
+  return allocatedByteCount.load(std::memory_order_relaxed);
+#else
+  return 0;
+#endif
+}
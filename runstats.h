@@ -0,0 +1,128 @@
+#ifndef RUNSTATS_H_
+#define RUNSTATS_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the RunStats class, which records how long each phase
+  of a run of Beth Yw? takes and what it does, for the --stats argument.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+  RunStats collects a Phase for each part of a run: its wall and CPU time,
+  the heap allocations made during it, the peak resident set size at its end,
+  and Counters of the work it did (filled in by whoever timed it).
+
+  A phase is timed by a RunStats::Timer, from when it is constructed until it
+  is stopped or destroyed. A Timer given a null RunStats does nothing, so
+  code can be timed unconditionally and only recorded when --stats is given.
+
+  The CPU time and allocations are those of the whole process, as there is no
+  portable way to measure a single thread's. Phases that run at the same time
+  (e.g. datasets imported on several threads) each include the others' CPU
+  time and allocations, although their wall times are their own.
+
+  Allocations are counted by replacing the global operator new, which makes
+  every allocation update shared counters. That is only compiled in when
+  BETHYW_COUNT_ALLOCATIONS is defined, as it is for the bench build target,
+  or e.g.:
+
+    CXXFLAGS=-DBETHYW_COUNT_ALLOCATIONS ./build.sh
+
+  Otherwise allocations are reported as "-" in the table and null in the
+  JSON. The peak resident set size is not available on Windows, and is
+  reported as 0.
+
+  @example
+    RunStats stats;
+    {
+      RunStats::Timer timer(&stats, "areas");
+      BethYw::loadAreas(data, dir, filter);
+      timer.counters().areasCreated = data.size();
+    }
+    stats.writeText(std::cerr);
+*/
+class RunStats {
+  public:
+    // What a phase did, where it applies to the phase
+    struct Counters {
+      std::uint64_t bytesRead = 0;
+      std::uint64_t rowsParsed = 0;
+      std::uint64_t rowsFiltered = 0;
+      std::uint64_t areasCreated = 0;
+      std::uint64_t measuresCreated = 0;
+      std::uint64_t valuesCreated = 0;
+
+      Counters& operator+=(const Counters& other) noexcept;
+    };
+
+    struct Phase {
+      std::string name;
+      double wallSeconds = 0;
+      double cpuSeconds = 0;
+      std::uint64_t allocations = 0;
+      std::uint64_t allocatedBytes = 0;
+      std::uint64_t peakResidentBytes = 0;
+      Counters counters;
+    };
+
+    class Timer {
+      public:
+        Timer(RunStats* stats, std::string name);
+        Timer(const Timer& other) = delete;
+        Timer& operator=(const Timer& other) = delete;
+        ~Timer();
+        Counters& counters() noexcept;
+        void stop();
+
+      private:
+        RunStats* stats;
+        Phase phase;
+        std::chrono::steady_clock::time_point wallStart;
+        double cpuStart;
+        std::uint64_t allocationsStart;
+        std::uint64_t allocatedBytesStart;
+    };
+
+  private:
+    mutable std::mutex mutex;
+    std::vector<Phase> phases;
+    std::chrono::steady_clock::time_point wallStart;
+    double cpuStart;
+    std::uint64_t allocationsStart;
+    std::uint64_t allocatedBytesStart;
+
+  public:
+    // True if allocations are counted in this build
+    static constexpr bool COUNTS_ALLOCATIONS =
+#ifdef BETHYW_COUNT_ALLOCATIONS
+        true;
+#else
+        false;
+#endif
+
+    RunStats();
+    void addPhase(Phase phase);
+    std::vector<Phase> getPhases() const;
+    Phase getTotal() const;
+    void writeText(std::ostream& os) const;
+    void writeJSON(std::ostream& os) const;
+
+    static double cpuSeconds() noexcept;
+    static std::uint64_t peakResidentBytes() noexcept;
+    static std::uint64_t allocations() noexcept;
+    static std::uint64_t allocatedBytes() noexcept;
+};
+
+#endif // RUNSTATS_H_
@@ -0,0 +1,393 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the QueryServer class. See the
+  header file for the protocol.
+*/
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "lib_cxxopts.hpp"
+
+#include "bethyw.h"
+#include "filter.h"
+#include "server.h"
+#include "threadpool.h"
+#include "trace.h"
+
+namespace {
+
+// The longest query line accepted, so a client cannot fill the memory
+constexpr std::size_t MAX_LINE_LENGTH = 64 * 1024;
+
+#ifndef _WIN32
+// Write all of data to a socket, without raising SIGPIPE if the client has
+// gone, returning false if it could not be written
+bool sendAll(int socket, const std::string& data) {
+#ifdef MSG_NOSIGNAL
+  const int flags = MSG_NOSIGNAL;
+#else
+  const int flags = 0;
+#endif
+  std::size_t sent = 0;
+  while(sent < data.size()){
+    const ssize_t written = ::send(socket, data.data() + sent,
+                                   data.size() - sent, flags);
+    if(written < 0){
+      if(errno == EINTR){
+        continue;
+      }
+      return false;
+    }
+    sent += static_cast<std::size_t>(written);
+  }
+  return true;
+}
+
+sockaddr_un socketAddress(const std::string& socketPath) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if(socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)){
+    throw std::runtime_error(
+        "QueryServer::serve: Invalid socket path " + socketPath);
+  }
+  std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+  return address;
+}
+#endif
+
+} // namespace
+
+/*
+  QueryServer::QueryServer(names)
+
+  Construct a QueryServer from the Areas loaded from areas.csv. Datasets are
+  added with addDataset().
+
+  @param names
+    The Areas from areas.csv, which the server takes over
+
+  @example
+    Areas names(Areas::Arena);
+    BethYw::loadAreas(names, "datasets/", FilterSpec());
+    QueryServer server(std::move(names));
+*/
+QueryServer::QueryServer(Areas&& names) : names(std::move(names)) {}
+
+/*
+  QueryServer::addDataset(source, data)
+
+  Add the Areas loaded from a dataset. Datasets must be added in the order of
+  BethYw::InputFiles::DATASETS, which is the order bethyw imports them in.
+
+  @param source
+    The dataset the data was loaded from
+
+  @param data
+    The Areas loaded from only that dataset, which the server takes over
+
+  @example
+    Areas popden(Areas::Arena);
+    BethYw::loadDatasets(popden, "datasets/", {source}, FilterSpec());
+    server.addDataset(source, std::move(popden));
+*/
+void QueryServer::addDataset(const BethYw::InputFileSource& source,
+                             Areas&& data) {
+  datasets.emplace_back(source, std::move(data));
+}
+
+/*
+  QueryServer::query(line)
+
+  Answer a query, given as the arguments bethyw would take on the command
+  line.
+
+  @param line
+    The arguments, separated by whitespace
+
+  @return
+    The output bethyw would print for those arguments. If --datasets is not
+    given, or is all, the output is for every dataset the server loaded
+
+  @throws
+    std::invalid_argument if an argument is invalid (with the same messages
+    as the BethYw::parse…Arg() functions), or a dataset named in --datasets
+    was not loaded, with the message: Dataset not loaded: <code>
+
+  @example
+    std::string output = server.query("--areas W06000011 --json");
+*/
+std::string QueryServer::query(const std::string& line) const {
+  BETHYW_TRACE_SCOPE("QueryServer::query");
+
+  // the arguments are parsed by cxxopts, as if given on the command line
+  std::vector<std::string> arguments{"bethyw"};
+  std::istringstream words(line);
+  std::string word;
+  while(words >> word){
+    arguments.push_back(word);
+  }
+  std::vector<char*> argv;
+  for(auto& argument : arguments){
+    argv.push_back(argument.data());
+  }
+  int argc = static_cast<int>(argv.size());
+  char** argvPointer = argv.data();
+
+  auto cxxopts = BethYw::cxxoptsSetup();
+  auto args = cxxopts.parse(argc, argvPointer);
+
+  const auto datasetsToQuery = BethYw::parseDatasetsArg(args);
+  const auto areasFilter = BethYw::parseAreasArg(args);
+  const auto measuresFilter = BethYw::parseMeasuresArg(args);
+  const YearFilterTuple yearsFilter = BethYw::parseYearsArg(args);
+  const FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+
+  // all, which is also the default, means every dataset that was loaded
+  // rather than every dataset bethyw knows
+  bool allDatasets = !args.count("datasets");
+  if(!allDatasets){
+    const auto& codes = args["datasets"].as<std::vector<std::string>>();
+    allDatasets = std::find(codes.begin(), codes.end(), "all") != codes.end();
+  }
+
+  for(const auto& source : datasetsToQuery){
+    const bool loaded = allDatasets || std::any_of(
+        datasets.begin(), datasets.end(),
+        [&source](const auto& dataset) {
+          return dataset.first.CODE == source.CODE;
+        });
+    if(!loaded){
+      throw std::invalid_argument("Dataset not loaded: " + source.CODE);
+    }
+  }
+
+  // Selected and merged in the same order as bethyw imports them, so the
+  // result is the same
+  Areas result = names.select(filter);
+  for(const auto& dataset : datasets){
+    const bool queried = std::any_of(
+        datasetsToQuery.begin(), datasetsToQuery.end(),
+        [&dataset](const BethYw::InputFileSource& source) {
+          return source.CODE == dataset.first.CODE;
+        });
+    if(allDatasets || queried){
+      result.merge(dataset.second.select(filter));
+    }
+  }
+
+  std::ostringstream output;
+  if(args.count("json")){
+    result.writeJSON(output);
+    output << std::endl;
+  }else{
+    output << result << std::endl;
+  }
+  return output.str();
+}
+
+/*
+  QueryServer::respond(line)
+
+  Answer a query as it is sent back to a client, see the protocol in the
+  header file.
+
+  @param line
+    The query
+
+  @return
+    "OK <length>\n" followed by the output of query(), or "ERROR <message>\n"
+    if the query could not be answered
+
+  @example
+    server.respond("--areas W06000011"); // "OK 1523\n<table>..."
+    server.respond("--years 20"); // "ERROR Invalid input for years argument\n"
+*/
+std::string QueryServer::respond(const std::string& line) const {
+  try{
+    std::string output = query(line);
+    return "OK " + std::to_string(output.size()) + "\n" + output;
+  } catch(const std::exception& e){
+    std::string message = e.what();
+    std::replace(message.begin(), message.end(), '\n', ' ');
+    return "ERROR " + message + "\n";
+  }
+}
+
+/*
+  QueryServer::serve(socketPath, threads)
+
+  Listen on a Unix domain socket and answer queries from clients until
+  stop() is called. Any file already at socketPath is replaced, and the
+  socket file is removed when the server stops.
+
+  @param socketPath
+    The path of the socket to create
+
+  @param threads
+    The number of clients to answer at once
+
+  @throws
+    std::runtime_error if the socket cannot be created, with the message:
+    QueryServer::serve: Failed to listen on <socketPath>
+    or on Windows, where Unix domain sockets are not supported
+
+  @example
+    std::thread serving([&server]() { server.serve("/tmp/bethyw.sock", 4); });
+    ...
+    server.stop();
+    serving.join();
+*/
+void QueryServer::serve(const std::string& socketPath, unsigned int threads) {
+#ifdef _WIN32
+  (void) socketPath;
+  (void) threads;
+  throw std::runtime_error(
+      "QueryServer::serve: Unix domain sockets are not supported on Windows");
+#else
+  const sockaddr_un address = socketAddress(socketPath);
+  const std::string failure =
+      "QueryServer::serve: Failed to listen on " + socketPath;
+
+  const int listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if(listener < 0){
+    throw std::runtime_error(failure);
+  }
+  ::unlink(socketPath.c_str());
+  if(::bind(listener, reinterpret_cast<const sockaddr*>(&address),
+            sizeof(address)) != 0 ||
+     ::listen(listener, SOMAXCONN) != 0){
+    ::close(listener);
+    throw std::runtime_error(failure);
+  }
+  {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    this->socketPath = socketPath;
+  }
+
+  {
+    ThreadPool pool(std::max(1u, threads));
+    while(!stopping){
+      const int client = ::accept(listener, nullptr, nullptr);
+      if(client < 0){
+        if(errno == EINTR || errno == ECONNABORTED){
+          continue;
+        }
+        break;
+      }
+      if(stopping){
+        ::close(client);
+        break;
+      }
+#ifdef SO_NOSIGPIPE
+      const int noSigPipe = 1;
+      ::setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe,
+                   sizeof(noSigPipe));
+#endif
+      {
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clients.insert(client);
+      }
+      pool.submit([this, client]() { handleClient(client); });
+    }
+    // the pool waits here for the clients still connected to finish
+  }
+
+  ::close(listener);
+  ::unlink(socketPath.c_str());
+#endif
+}
+
+/*
+  QueryServer::stop()
+
+  Stop serve(), closing the connection of every client once it has had the
+  reply to the query it is waiting for. This may be called from any thread.
+*/
+void QueryServer::stop() {
+  stopping = true;
+#ifndef _WIN32
+  std::lock_guard<std::mutex> lock(clientsMutex);
+  // a client that is waiting for its next query sees the connection close
+  for(int client : clients){
+    ::shutdown(client, SHUT_RD);
+  }
+  // connecting wakes serve() if it is waiting for a client
+  if(!socketPath.empty()){
+    const sockaddr_un address = socketAddress(socketPath);
+    const int wake = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(wake >= 0){
+      ::connect(wake, reinterpret_cast<const sockaddr*>(&address),
+                sizeof(address));
+      ::close(wake);
+    }
+  }
+#endif
+}
+
+// Answer the queries sent on one connection, one line at a time, until the
+// client closes it, sends "quit" or the server stops
+void QueryServer::handleClient(int client) {
+#ifndef _WIN32
+  std::string buffer;
+  char chunk[4096];
+  bool open = true;
+  while(open && !stopping){
+    const ssize_t received = ::recv(client, chunk, sizeof(chunk), 0);
+    if(received < 0 && errno == EINTR){
+      continue;
+    }
+    if(received <= 0){
+      break;
+    }
+    buffer.append(chunk, static_cast<std::size_t>(received));
+
+    std::size_t start = 0;
+    std::size_t newline;
+    while(open && (newline = buffer.find('\n', start)) != std::string::npos){
+      std::string line = buffer.substr(start, newline - start);
+      start = newline + 1;
+      if(!line.empty() && line.back() == '\r'){
+        line.pop_back();
+      }
+      if(line == "quit"){
+        open = false;
+      }else if(line.find_first_not_of(" \t") != std::string::npos){
+        open = sendAll(client, respond(line));
+      }
+    }
+    buffer.erase(0, start);
+
+    if(buffer.size() > MAX_LINE_LENGTH){
+      sendAll(client, "ERROR Query is too long\n");
+      open = false;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(clientsMutex);
+    clients.erase(client);
+  }
+  ::close(client);
+#else
+  (void) client;
+#endif
+}
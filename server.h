@@ -0,0 +1,92 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the QueryServer class, which keeps imported data in
+  memory and answers queries on it over a Unix domain socket, for the --serve
+  argument.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "areas.h"
+#include "datasets.h"
+
+/*
+  A QueryServer holds the Areas from areas.csv and from each dataset, each
+  loaded once, and answers queries by selecting from them (see
+  Areas::select()) rather than parsing the files again.
+
+  The protocol is line based. Each query is one line holding the same
+  arguments that bethyw takes on the command line to choose and print data:
+  --datasets, --areas, --measures, --years and --json. Other arguments are
+  ignored. The reply to a query is either
+
+    OK <length>\n<the output>
+
+  where the output is exactly what bethyw would print with those arguments
+  and is <length> bytes long, or
+
+    ERROR <message>\n
+
+  A query without --datasets, or with --datasets all, is answered from every
+  dataset the server loaded, so an empty query returns everything it holds.
+  Naming a dataset that was not loaded when the server started is an error.
+  Blank lines are ignored, and a line holding only "quit" closes the
+  connection. A query line is at most 64 KiB, which also bounds the size of
+  its filters.
+
+  Each connection is handled by one thread of a ThreadPool, so the number of
+  threads is the number of clients answered at once; other clients wait for
+  a free thread. Queries only read the loaded data, so they never wait for
+  each other.
+
+  Unix domain sockets are not available on Windows, where serve() throws,
+  but query() can still be used.
+
+  @example
+    Areas names(Areas::Arena);
+    BethYw::loadAreas(names, "datasets/", FilterSpec());
+    QueryServer server(std::move(names));
+    ...
+    server.serve("/tmp/bethyw.sock", 4);
+
+    // in a shell:
+    //   printf -- '--areas W06000011 --measures pop --json\n' \
+    //     | nc -U /tmp/bethyw.sock
+*/
+class QueryServer {
+  private:
+    Areas names;
+    std::vector<std::pair<BethYw::InputFileSource, Areas>> datasets;
+
+    std::atomic<bool> stopping{false};
+    std::string socketPath;
+    std::mutex clientsMutex;
+    std::unordered_set<int> clients;
+
+    void handleClient(int client);
+
+  public:
+    explicit QueryServer(Areas&& names);
+    QueryServer(const QueryServer& other) = delete;
+    QueryServer& operator=(const QueryServer& other) = delete;
+    void addDataset(const BethYw::InputFileSource& source, Areas&& data);
+    std::string query(const std::string& line) const;
+    std::string respond(const std::string& line) const;
+    void serve(const std::string& socketPath, unsigned int threads);
+    void stop();
+};
+
+#endif // SERVER_H_
@@ -0,0 +1,206 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the snapshot functions. See the
+  header file for the layout of a snapshot.
+*/
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "snapshot.h"
+#include "trace.h"
+
+namespace {
+
+const char MAGIC[8] = {'B', 'Y', 'W', 'S', 'N', 'A', 'P', '\0'};
+const std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+template <typename T>
+void writeNumber(std::ostream& os, T value) {
+  os.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void writeString(std::ostream& os, std::string_view str) {
+  writeNumber<std::uint32_t>(os, str.size());
+  os.write(str.data(), str.size());
+}
+
+/*
+  Reads numbers and strings from the front of a snapshot, checking each one
+  fits in what is left of the data.
+*/
+class SnapshotReader {
+  public:
+    SnapshotReader(std::string_view data) : data(data) {}
+
+    template <typename T>
+    T readNumber() {
+      T value;
+      std::memcpy(&value, take(sizeof(T)).data(), sizeof(T));
+      return value;
+    }
+
+    std::string readString() {
+      return std::string(readView());
+    }
+
+    std::string_view readView() {
+      return take(readNumber<std::uint32_t>());
+    }
+
+    std::string_view take(std::size_t bytes) {
+      if(bytes > data.size()){
+        throw std::runtime_error("Snapshot::read: Snapshot is truncated");
+      }
+      std::string_view taken = data.substr(0, bytes);
+      data.remove_prefix(bytes);
+      return taken;
+    }
+
+    bool empty() const {
+      return data.empty();
+    }
+
+  private:
+    std::string_view data;
+};
+
+} // namespace
+
+/*
+  Snapshot::write(os, areas)
+
+  Write every Area in areas to an output stream as a binary snapshot.
+
+  @param os
+    The stream to write to, which should be opened in binary mode
+
+  @param areas
+    The Areas instance to save
+
+  @throws
+    std::runtime_error if the stream fails
+
+  @example
+    std::ofstream file("bethyw.snapshot", std::ios::binary);
+    Snapshot::write(file, areas);
+*/
+void Snapshot::write(std::ostream& os, const Areas& areas) {
+  BETHYW_TRACE_SCOPE("Snapshot::write");
+  os.write(MAGIC, sizeof(MAGIC));
+  writeNumber(os, VERSION);
+  writeNumber(os, BYTE_ORDER_MARK);
+
+  writeNumber<std::uint32_t>(os, areas.size());
+  for(const auto& area : areas.getAreasView()){
+    writeString(os, area.first);
+
+    writeNumber<std::uint32_t>(os, area.second.getNamesView().size());
+    for(const auto& name : area.second.getNamesView()){
+      writeString(os, name.first);
+      writeString(os, name.second);
+    }
+
+    writeNumber<std::uint32_t>(os, area.second.getMeasuresView().size());
+    for(const auto& measure : area.second.getMeasuresView()){
+      writeString(os, measure.second.getCodename());
+      writeString(os, measure.second.getLabel());
+      writeNumber<std::uint32_t>(os, measure.second.size());
+      for(const auto& value : measure.second){
+        writeNumber<std::int32_t>(os, value.first);
+        writeNumber<double>(os, value.second);
+      }
+    }
+  }
+
+  if(!os){
+    throw std::runtime_error("Snapshot::write: Failed to write snapshot");
+  }
+}
+
+/*
+  Snapshot::read(data, areas)
+
+  Load the Areas saved in a snapshot by Snapshot::write(), such as the view
+  returned by MappedInputFile::open(). The Areas are created in areas with
+  Areas::findOrCreateArea(), so they are allocated from its memory.
+
+  @param data
+    The contents of the snapshot
+
+  @param areas
+    The Areas instance to load into, which would normally be empty
+
+  @throws
+    std::runtime_error if data is not a snapshot, is from a different version
+    or byte order, is truncated, or holds years that write() could not have
+    written (out of order, or too far apart for a Measure)
+
+  @example
+    MappedInputFile input("bethyw.snapshot");
+    Areas areas = Areas();
+    Snapshot::read(input.open(), areas);
+*/
+void Snapshot::read(std::string_view data, Areas& areas) {
+  BETHYW_TRACE_SCOPE("Snapshot::read");
+  SnapshotReader reader(data);
+
+  if(reader.take(sizeof(MAGIC)) != std::string_view(MAGIC, sizeof(MAGIC))){
+    throw std::runtime_error("Snapshot::read: Data is not a snapshot");
+  }
+  if(reader.readNumber<std::uint32_t>() != VERSION ||
+     reader.readNumber<std::uint32_t>() != BYTE_ORDER_MARK){
+    throw std::runtime_error("Snapshot::read: Snapshot is from another version");
+  }
+
+  // codes, codenames and labels repeat across the Areas, as they do in the
+  // datasets, so they are interned through a cache as the parsers do
+  SymbolCache symbols;
+  const std::uint32_t numAreas = reader.readNumber<std::uint32_t>();
+  for(std::uint32_t i = 0; i < numAreas; i++){
+    Area& area = areas.findOrCreateArea(symbols.get(reader.readView()));
+
+    const std::uint32_t numNames = reader.readNumber<std::uint32_t>();
+    for(std::uint32_t j = 0; j < numNames; j++){
+      std::string lang = reader.readString();
+      area.setName(std::move(lang), reader.readString());
+    }
+
+    const std::uint32_t numMeasures = reader.readNumber<std::uint32_t>();
+    for(std::uint32_t j = 0; j < numMeasures; j++){
+      const Symbol codename = symbols.get(reader.readView());
+      Measure measure(codename, symbols.get(reader.readView()),
+                      areas.getResource());
+      const std::uint32_t numValues = reader.readNumber<std::uint32_t>();
+      std::int32_t firstYear = 0;
+      std::int32_t lastYear = 0;
+      for(std::uint32_t k = 0; k < numValues; k++){
+        const std::int32_t year = reader.readNumber<std::int32_t>();
+        // write() saves each measure's years in order, and a Measure cannot
+        // hold years further apart than Measure::MAX_YEAR_SPAN
+        if(k == 0){
+          firstYear = year;
+        }else if(year <= lastYear ||
+                 (long long) year - firstYear >= Measure::MAX_YEAR_SPAN){
+          throw std::runtime_error("Snapshot::read: Snapshot is corrupt");
+        }
+        lastYear = year;
+        measure.setValue(year, reader.readNumber<double>());
+      }
+      area.setMeasure(codename, std::move(measure));
+    }
+  }
+
+  if(!reader.empty()){
+    throw std::runtime_error("Snapshot::read: Unexpected data after snapshot");
+  }
+}
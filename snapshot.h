@@ -0,0 +1,51 @@
+#ifndef SNAPSHOT_H_
+#define SNAPSHOT_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the functions for saving a populated Areas instance to a
+  compact binary snapshot, and loading it back without re-parsing the source
+  datasets.
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+#include "areas.h"
+
+/*
+  A snapshot holds every Area in an Areas instance, with its names and its
+  measures' values, in the order they are stored. It is laid out as:
+
+    header   "BYWSNAP" '\0', a uint32 format version and a uint32 byte order
+             mark (0x01020304)
+    uint32   number of areas, then for each area:
+      string   local authority code
+      uint32   number of names, then for each: string language, string name
+      uint32   number of measures, then for each:
+        string   codename
+        string   label
+        uint32   number of values, then for each: int32 year, double value
+
+  where each string is a uint32 length followed by its bytes. Numbers are
+  written in the byte order of the machine, so a snapshot is a cache for the
+  machine that wrote it rather than a format for exchanging data, and read()
+  rejects a snapshot with a different byte order or version.
+*/
+namespace Snapshot {
+
+const std::uint32_t VERSION = 1;
+
+void write(std::ostream& os, const Areas& areas);
+
+void read(std::string_view data, Areas& areas);
+
+} // namespace Snapshot
+
+#endif // SNAPSHOT_H_
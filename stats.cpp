@@ -0,0 +1,378 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the statistics kernels. See the
+  header file for additional comments.
+*/
+
+#include <algorithm>
+#include <limits>
+
+#include "stats.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define STATS_AVX2
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define STATS_SSE2
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// The presence bits of the values [i, i + lanes), where i is a multiple of
+// lanes, as the low bits of the result
+inline unsigned int presentBits(const std::uint64_t* present,
+                                std::size_t i,
+                                unsigned int lanes) {
+  return (present[i / 64] >> (i % 64)) & ((1u << lanes) - 1);
+}
+
+inline bool isPresent(const std::uint64_t* present, std::size_t i) {
+  return (present[i / 64] >> (i % 64)) & 1;
+}
+
+inline unsigned int countTrailingZeros(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(word);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long index;
+  _BitScanForward64(&index, word);
+  return index;
+#else
+  unsigned int zeros = 0;
+  while((word & 1) == 0){
+    word >>= 1;
+    zeros++;
+  }
+  return zeros;
+#endif
+}
+
+#if defined(STATS_AVX2)
+
+// All ones in each lane whose presence bit is set, for masking four values
+inline __m256d laneMask(unsigned int bits) {
+  const __m256i lanes = _mm256_set_epi64x(8, 4, 2, 1);
+  const __m256i set = _mm256_and_si256(_mm256_set1_epi64x(bits), lanes);
+  return _mm256_castsi256_pd(_mm256_cmpeq_epi64(set, lanes));
+}
+
+inline __m256d select(__m256d mask, __m256d ifSet, __m256d ifClear) {
+  return _mm256_blendv_pd(ifClear, ifSet, mask);
+}
+
+inline double horizontalSum(__m256d v) {
+  __m128d half = _mm_add_pd(_mm256_castpd256_pd128(v),
+                            _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(half, _mm_unpackhi_pd(half, half)));
+}
+
+#elif defined(STATS_SSE2)
+
+// All ones in each lane whose presence bit is set, for masking two values
+inline __m128d laneMask(unsigned int bits) {
+  return _mm_castsi128_pd(_mm_set_epi64x(-(long long) ((bits >> 1) & 1),
+                                         -(long long) (bits & 1)));
+}
+
+inline __m128d select(__m128d mask, __m128d ifSet, __m128d ifClear) {
+  return _mm_or_pd(_mm_and_pd(mask, ifSet), _mm_andnot_pd(mask, ifClear));
+}
+
+inline double horizontalSum(__m128d v) {
+  return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+#endif
+
+} // namespace
+
+/*
+  Stats::combine(lhs, rhs)
+
+  Combine the Summaries of two series into the Summary of both together,
+  without going back to the values (using the pairwise variance formula of
+  Chan et al.).
+
+  @param lhs
+    The Summary of the first series
+
+  @param rhs
+    The Summary of the second series
+
+  @return
+    The Summary of both series
+
+  @example
+    Stats::Summary all;
+    for(const auto& area : areas.getAreasView()){
+      all = Stats::combine(all, area.second.getMeasure("pop").getSummary());
+    }
+*/
+Stats::Summary Stats::combine(const Summary& lhs, const Summary& rhs) {
+  if(lhs.count == 0){
+    return rhs;
+  }
+  if(rhs.count == 0){
+    return lhs;
+  }
+
+  Summary combined;
+  combined.count = lhs.count + rhs.count;
+  combined.sum = lhs.sum + rhs.sum;
+  combined.min = std::min(lhs.min, rhs.min);
+  combined.max = std::max(lhs.max, rhs.max);
+  combined.mean = combined.sum / combined.count;
+
+  const double delta = rhs.mean - lhs.mean;
+  const double squaredDeviations =
+      lhs.variance * lhs.count + rhs.variance * rhs.count +
+      delta * delta * lhs.count * rhs.count / combined.count;
+  combined.variance = squaredDeviations / combined.count;
+  return combined;
+}
+
+/*
+  Stats::sum(values, n)
+
+  Add up a buffer of values. Absent years hold 0, so no mask is needed. This
+  is how Measure::accumulate() totals a Measure after adding another into it.
+
+  @param values
+    The values to add up
+
+  @param n
+    The number of values
+
+  @return
+    The sum of the values
+*/
+double Stats::sum(const double* values, std::size_t n) {
+  double total = 0;
+  std::size_t i = 0;
+#if defined(STATS_AVX2)
+  __m256d acc = _mm256_setzero_pd();
+  for(; i + 4 <= n; i += 4){
+    acc = _mm256_add_pd(acc, _mm256_loadu_pd(values + i));
+  }
+  total = horizontalSum(acc);
+#elif defined(STATS_SSE2)
+  __m128d acc = _mm_setzero_pd();
+  for(; i + 2 <= n; i += 2){
+    acc = _mm_add_pd(acc, _mm_loadu_pd(values + i));
+  }
+  total = horizontalSum(acc);
+#endif
+  for(; i < n; i++){
+    total += values[i];
+  }
+  return total;
+}
+
+/*
+  Stats::addInto(totals, values, n)
+
+  Add each value to the matching total, e.g. to total a measure across areas
+  year by year.
+
+  @param totals
+    The running totals, which are updated
+
+  @param values
+    The values to add to the totals
+
+  @param n
+    The number of values
+*/
+void Stats::addInto(double* totals, const double* values, std::size_t n) {
+  std::size_t i = 0;
+#if defined(STATS_AVX2)
+  for(; i + 4 <= n; i += 4){
+    _mm256_storeu_pd(totals + i, _mm256_add_pd(_mm256_loadu_pd(totals + i),
+                                               _mm256_loadu_pd(values + i)));
+  }
+#elif defined(STATS_SSE2)
+  for(; i + 2 <= n; i += 2){
+    _mm_storeu_pd(totals + i, _mm_add_pd(_mm_loadu_pd(totals + i),
+                                         _mm_loadu_pd(values + i)));
+  }
+#endif
+  for(; i < n; i++){
+    totals[i] += values[i];
+  }
+}
+
+/*
+  Stats::minMax(values, present, n, min, max)
+
+  Find the smallest and largest of the values that are present.
+
+  @param values
+    The values to search
+
+  @param present
+    The presence mask of the values
+
+  @param n
+    The number of values
+
+  @param min
+    Set to the smallest value present, or 0 if none are
+
+  @param max
+    Set to the largest value present, or 0 if none are
+*/
+void Stats::minMax(const double* values,
+                   const std::uint64_t* present,
+                   std::size_t n,
+                   double& min,
+                   double& max) {
+  const double infinity = std::numeric_limits<double>::infinity();
+  double lowest = infinity;
+  double highest = -infinity;
+  std::size_t i = 0;
+#if defined(STATS_AVX2)
+  const __m256d positive = _mm256_set1_pd(infinity);
+  const __m256d negative = _mm256_set1_pd(-infinity);
+  __m256d low = positive;
+  __m256d high = negative;
+  for(; i + 4 <= n; i += 4){
+    const __m256d x = _mm256_loadu_pd(values + i);
+    const __m256d mask = laneMask(presentBits(present, i, 4));
+    low = _mm256_min_pd(low, select(mask, x, positive));
+    high = _mm256_max_pd(high, select(mask, x, negative));
+  }
+  double lows[4], highs[4];
+  _mm256_storeu_pd(lows, low);
+  _mm256_storeu_pd(highs, high);
+  lowest = std::min(std::min(lows[0], lows[1]), std::min(lows[2], lows[3]));
+  highest = std::max(std::max(highs[0], highs[1]), std::max(highs[2], highs[3]));
+#elif defined(STATS_SSE2)
+  const __m128d positive = _mm_set1_pd(infinity);
+  const __m128d negative = _mm_set1_pd(-infinity);
+  __m128d low = positive;
+  __m128d high = negative;
+  for(; i + 2 <= n; i += 2){
+    const __m128d x = _mm_loadu_pd(values + i);
+    const __m128d mask = laneMask(presentBits(present, i, 2));
+    low = _mm_min_pd(low, select(mask, x, positive));
+    high = _mm_max_pd(high, select(mask, x, negative));
+  }
+  double lows[2], highs[2];
+  _mm_storeu_pd(lows, low);
+  _mm_storeu_pd(highs, high);
+  lowest = std::min(lows[0], lows[1]);
+  highest = std::max(highs[0], highs[1]);
+#endif
+  for(; i < n; i++){
+    if(isPresent(present, i)){
+      lowest = std::min(lowest, values[i]);
+      highest = std::max(highest, values[i]);
+    }
+  }
+
+  if(lowest > highest){
+    lowest = highest = 0;
+  }
+  min = lowest;
+  max = highest;
+}
+
+/*
+  Stats::sumSquaredDeviations(values, present, n, mean)
+
+  Add up the squared difference between each value present and the mean,
+  which divided by the number of values gives the variance.
+
+  @param values
+    The values
+
+  @param present
+    The presence mask of the values
+
+  @param n
+    The number of values
+
+  @param mean
+    The mean of the values present
+
+  @return
+    The sum of the squared deviations from the mean
+*/
+double Stats::sumSquaredDeviations(const double* values,
+                                   const std::uint64_t* present,
+                                   std::size_t n,
+                                   double mean) {
+  double total = 0;
+  std::size_t i = 0;
+#if defined(STATS_AVX2)
+  const __m256d means = _mm256_set1_pd(mean);
+  __m256d acc = _mm256_setzero_pd();
+  for(; i + 4 <= n; i += 4){
+    const __m256d deviation = _mm256_sub_pd(_mm256_loadu_pd(values + i), means);
+    const __m256d mask = laneMask(presentBits(present, i, 4));
+    acc = _mm256_add_pd(acc, _mm256_and_pd(mask, _mm256_mul_pd(deviation, deviation)));
+  }
+  total = horizontalSum(acc);
+#elif defined(STATS_SSE2)
+  const __m128d means = _mm_set1_pd(mean);
+  __m128d acc = _mm_setzero_pd();
+  for(; i + 2 <= n; i += 2){
+    const __m128d deviation = _mm_sub_pd(_mm_loadu_pd(values + i), means);
+    const __m128d mask = laneMask(presentBits(present, i, 2));
+    acc = _mm_add_pd(acc, _mm_and_pd(mask, _mm_mul_pd(deviation, deviation)));
+  }
+  total = horizontalSum(acc);
+#endif
+  for(; i < n; i++){
+    if(isPresent(present, i)){
+      const double deviation = values[i] - mean;
+      total += deviation * deviation;
+    }
+  }
+  return total;
+}
+
+/*
+  Stats::nextPresent(present, n, from)
+
+  Find the first value at or after a position that is present, skipping
+  whole words of absent values at a time.
+
+  @param present
+    The presence mask of the values
+
+  @param n
+    The number of values
+
+  @param from
+    The position to start looking from
+
+  @return
+    The position of the next value present, or n if there is none
+*/
+std::size_t Stats::nextPresent(const std::uint64_t* present,
+                               std::size_t n,
+                               std::size_t from) {
+  while(from < n){
+    const std::uint64_t word = present[from / 64] >> (from % 64);
+    if(word != 0){
+      from += countTrailingZeros(word);
+      return std::min(from, n);
+    }
+    from = (from / 64 + 1) * 64;
+  }
+  return n;
+}
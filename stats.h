@@ -0,0 +1,68 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the statistics kernels that work over the dense year
+  buffers of a Measure, and the Summary of a series of values that they
+  produce.
+ */
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+  The kernels take a buffer of values, one per year, and a presence mask with
+  one bit per value (bit i % 64 of word i / 64) saying whether that year has a
+  value, as stored by Measure. Values for absent years must be 0.
+
+  Each kernel is implemented with AVX2 or SSE2 intrinsics when the compiler
+  targets them (AVX2 with -mavx2, as in ./build.sh avx2 and bench-avx2, or
+  SSE2 on any x86-64 build), and with plain loops otherwise, chosen at
+  compile time. As the vector versions add values in a different order, a
+  sum may differ from a plain loop in the last bits.
+*/
+namespace Stats {
+
+/*
+  The count, sum, minimum, maximum, mean and (population) variance of a
+  series of values. All are 0 for an empty series.
+*/
+struct Summary {
+  int count = 0;
+  double sum = 0;
+  double min = 0;
+  double max = 0;
+  double mean = 0;
+  double variance = 0;
+};
+
+Summary combine(const Summary& lhs, const Summary& rhs);
+
+double sum(const double* values, std::size_t n);
+
+void addInto(double* totals, const double* values, std::size_t n);
+
+void minMax(const double* values,
+            const std::uint64_t* present,
+            std::size_t n,
+            double& min,
+            double& max);
+
+double sumSquaredDeviations(const double* values,
+                            const std::uint64_t* present,
+                            std::size_t n,
+                            double mean);
+
+std::size_t nextPresent(const std::uint64_t* present,
+                        std::size_t n,
+                        std::size_t from);
+
+} // namespace Stats
+
+#endif // STATS_H_
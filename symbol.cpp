@@ -0,0 +1,185 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the Symbol class and its symbol
+  table. See the header file for additional comments.
+*/
+
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include "symbol.h"
+
+namespace {
+
+/*
+  The interned strings live in a std::deque, which never moves its elements,
+  and are indexed by a hash map keyed on views of them, so that text can be
+  looked up without first copying it into a std::string.
+*/
+class SymbolTable {
+  public:
+    const std::string* intern(std::string_view text) {
+      {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        auto it = index.find(text);
+        if(it != index.end()){
+          return &strings[it->second];
+        }
+      }
+
+      std::unique_lock<std::shared_mutex> lock(mutex);
+      // another thread may have added it between the two locks
+      auto it = index.find(text);
+      if(it != index.end()){
+        return &strings[it->second];
+      }
+      strings.emplace_back(text);
+      index.emplace(strings.back(), strings.size() - 1);
+      return &strings.back();
+    }
+
+    const std::string* find(std::string_view text) const {
+      std::shared_lock<std::shared_mutex> lock(mutex);
+      auto it = index.find(text);
+      return it == index.end() ? nullptr : &strings[it->second];
+    }
+
+    std::size_t size() const {
+      std::shared_lock<std::shared_mutex> lock(mutex);
+      return strings.size();
+    }
+
+  private:
+    mutable std::shared_mutex mutex;
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, std::size_t> index;
+};
+
+SymbolTable& table() {
+  static SymbolTable symbols;
+  return symbols;
+}
+
+const std::string& emptyString() {
+  static const std::string empty;
+  return empty;
+}
+
+} // namespace
+
+/*
+  Symbol::Symbol()
+
+  Construct a Symbol for the empty string, without touching the table.
+*/
+Symbol::Symbol() noexcept : str(&emptyString()) {}
+
+/*
+  Symbol::Symbol(text)
+
+  Construct a Symbol for some text, interning the text if this is the first
+  Symbol for it.
+
+  @param text
+    The text of the Symbol
+
+  @example
+    Symbol code("W06000011");
+    Symbol same(std::string("W06000011")); // code == same
+*/
+Symbol::Symbol(std::string_view text)
+    : str(text.empty() ? &emptyString() : table().intern(text)) {}
+
+Symbol::Symbol(const std::string& text) : Symbol(std::string_view(text)) {}
+
+Symbol::Symbol(const char* text) : Symbol(std::string_view(text)) {}
+
+/*
+  Symbol::find(text)
+
+  Get the Symbol for some text if it has been interned, without adding it to
+  the table.
+
+  @param text
+    The text to look for
+
+  @return
+    The Symbol for the text, or std::nullopt if there is none
+
+  @example
+    auto code = Symbol::find("W06000011");
+    if(code){
+      auto it = areas.find(*code);
+    }
+*/
+std::optional<Symbol> Symbol::find(std::string_view text) {
+  if(text.empty()){
+    return Symbol();
+  }
+  const std::string* str = table().find(text);
+  if(str == nullptr){
+    return std::nullopt;
+  }
+  Symbol symbol;
+  symbol.str = str;
+  return symbol;
+}
+
+/*
+  Symbol::isInterned(text)
+
+  @param text
+    The text to look for
+
+  @return
+    True if a Symbol has been created for the text
+*/
+bool Symbol::isInterned(std::string_view text) {
+  return find(text).has_value();
+}
+
+/*
+  Symbol::tableSize()
+
+  @return
+    The number of distinct strings interned so far
+*/
+std::size_t Symbol::tableSize() {
+  return table().size();
+}
+
+/*
+  SymbolCache::get(text)
+
+  Get the Symbol for some text, interning the text the first time this cache
+  is asked for it.
+
+  @param text
+    The text of the Symbol
+
+  @return
+    The Symbol for the text, equal to Symbol(text)
+
+  @example
+    SymbolCache symbols;
+    Symbol code = symbols.get("W06000011"); // interned, or found in the table
+    Symbol same = symbols.get("W06000011"); // found in the cache
+*/
+Symbol SymbolCache::get(std::string_view text) {
+  auto it = symbols.find(text);
+  if(it == symbols.end()){
+    const Symbol symbol(text);
+    it = symbols.emplace(symbol, symbol).first;
+  }
+  return it->second;
+}
@@ -0,0 +1,174 @@
+#ifndef SYMBOL_H_
+#define SYMBOL_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the Symbol class, a handle to a string interned in a
+  process-wide symbol table.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+/*
+  A Symbol refers to one copy of a string held in a process-wide symbol
+  table, so every Symbol with the same text points to the same string.
+  Authority codes, measure codenames and labels repeat across every row of a
+  dataset and every Area, so each Area and Measure holds them as Symbols
+  rather than keeping its own copy.
+
+  Copying a Symbol copies a pointer, and comparing two Symbols for equality
+  compares pointers. Ordering compares the text, so containers keyed by
+  Symbols keep the same order as if they were keyed by std::string. A Symbol
+  converts to const std::string& and std::string_view, and can be compared
+  with and ordered against any string type without interning it, e.g. for
+  lookups with std::less<>.
+
+  Creating a Symbol looks its text up in the table, adding it if it is new.
+  The constructors are explicit, so that text is only interned where a Symbol
+  is created on purpose, such as by the parsers, and never by an implicit
+  conversion. Symbol::find() looks text up without adding it, for searching
+  containers keyed by Symbols: text that was never interned cannot be a key.
+  The table is guarded by a std::shared_mutex, so Symbols can be created from
+  several threads at once; lookups of existing text only take a shared lock.
+  Even so, the parsers create Symbols through a SymbolCache (below), so that
+  threads importing at once do not share the lock on every row. Interned
+  strings are never freed.
+*/
+class Symbol {
+  private:
+    const std::string* str;
+
+    template <typename T>
+    using IfText = std::enable_if_t<
+        std::is_convertible_v<const T&, std::string_view> &&
+        !std::is_same_v<T, Symbol>, bool>;
+  public:
+    Symbol() noexcept;
+    explicit Symbol(std::string_view text);
+    explicit Symbol(const std::string& text);
+    explicit Symbol(const char* text);
+
+    const std::string& string() const noexcept {
+      return *str;
+    }
+
+    operator const std::string&() const noexcept {
+      return *str;
+    }
+
+    operator std::string_view() const noexcept {
+      return *str;
+    }
+
+    std::size_t size() const noexcept {
+      return str->size();
+    }
+
+    bool empty() const noexcept {
+      return str->empty();
+    }
+
+    static std::optional<Symbol> find(std::string_view text);
+    static bool isInterned(std::string_view text);
+    static std::size_t tableSize();
+
+    friend bool operator==(const Symbol& lhs, const Symbol& rhs) noexcept {
+      return lhs.str == rhs.str;
+    }
+
+    friend bool operator!=(const Symbol& lhs, const Symbol& rhs) noexcept {
+      return lhs.str != rhs.str;
+    }
+
+    friend bool operator<(const Symbol& lhs, const Symbol& rhs) noexcept {
+      return lhs.str != rhs.str && *lhs.str < *rhs.str;
+    }
+
+    template <typename T, IfText<T> = true>
+    friend bool operator==(const Symbol& lhs, const T& rhs) noexcept {
+      return std::string_view(*lhs.str) == std::string_view(rhs);
+    }
+
+    template <typename T, IfText<T> = true>
+    friend bool operator==(const T& lhs, const Symbol& rhs) noexcept {
+      return std::string_view(lhs) == std::string_view(*rhs.str);
+    }
+
+    template <typename T, IfText<T> = true>
+    friend bool operator!=(const Symbol& lhs, const T& rhs) noexcept {
+      return !(lhs == rhs);
+    }
+
+    template <typename T, IfText<T> = true>
+    friend bool operator!=(const T& lhs, const Symbol& rhs) noexcept {
+      return !(lhs == rhs);
+    }
+
+    template <typename T, IfText<T> = true>
+    friend bool operator<(const Symbol& lhs, const T& rhs) noexcept {
+      return std::string_view(*lhs.str) < std::string_view(rhs);
+    }
+
+    template <typename T, IfText<T> = true>
+    friend bool operator<(const T& lhs, const Symbol& rhs) noexcept {
+      return std::string_view(lhs) < std::string_view(*rhs.str);
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, const Symbol& symbol) {
+      return os << *symbol.str;
+    }
+};
+
+/*
+  Symbols are interned, so a Symbol is hashed by its address.
+*/
+namespace std {
+
+template <>
+struct hash<Symbol> {
+  std::size_t operator()(const Symbol& symbol) const noexcept {
+    return std::hash<const std::string*>()(&symbol.string());
+  }
+};
+
+} // namespace std
+
+/*
+  A SymbolCache remembers the Symbols made through it, so that text it has
+  seen before is found without going to the symbol table, and so without
+  taking the table's lock. Each import (or each chunk of one, when rows are
+  parsed on several threads) keeps its own cache: the codes and labels of a
+  dataset repeat on every row, so the table is only visited once for each
+  distinct string in the chunk rather than once per row.
+
+  A SymbolCache is not thread-safe, and is meant to live only as long as the
+  import it is used for.
+
+  @example
+    SymbolCache symbols;
+    for(const auto& row : rows){
+      Area& area = areas.findOrCreateArea(symbols.get(row.authCode));
+      ...
+    }
+*/
+class SymbolCache {
+  private:
+    // keyed by views of the interned strings, which are never freed
+    std::unordered_map<std::string_view, Symbol> symbols;
+  public:
+    Symbol get(std::string_view text);
+};
+
+#endif // SYMBOL_H_
@@ -0,0 +1,156 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+
+#include "../csv.h"
+#include "../datasets.h"
+#include "../areas.h"
+#include "../input.h"
+
+SCENARIO( "CSV data can be tokenized into fields", "[CSVReader]" ) {
+
+  GIVEN( "CSV data with quoted fields, escaped quotes, CRLF line endings and blank lines" ) {
+
+    const std::string data = "h1,h2,h3\n"
+                             "\"a,b\",\"say \"\"hi\"\"\",c\r\n"
+                             "\n"
+                             "\"multi\nline\",,\n";
+
+    auto check = [](CSVReader &reader) {
+      auto field = [&reader](std::size_t i) {
+        return std::string(reader.fields()[i]);
+      };
+
+      REQUIRE( reader.nextRow() );
+      REQUIRE( reader.fields().size() == 3 );
+      REQUIRE( field(0) == "h1" );
+
+      REQUIRE( reader.nextRow() );
+      REQUIRE( reader.fields().size() == 3 );
+      REQUIRE( field(0) == "a,b" );
+      REQUIRE( field(1) == "say \"hi\"" );
+      REQUIRE( field(2) == "c" );
+
+      REQUIRE( reader.nextRow() );
+      REQUIRE( reader.fields().size() == 3 );
+      REQUIRE( field(0) == "multi\nline" );
+      REQUIRE( field(1) == "" );
+      REQUIRE( field(2) == "" );
+
+      REQUIRE_FALSE( reader.nextRow() );
+    };
+
+    WHEN( "it is read from a std::string_view" ) {
+
+      CSVReader reader{std::string_view(data)};
+
+      THEN( "each row is split into the correct fields" ) {
+
+        check(reader);
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "it is read from a std::istream" ) {
+
+      std::istringstream stream(data);
+      CSVReader reader(stream);
+
+      THEN( "each row is split into the correct fields" ) {
+
+        check(reader);
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "CSV data with an unterminated quoted field" ) {
+
+    const std::string data = "h1,h2\n\"open,field\n";
+    CSVReader reader{std::string_view(data)};
+
+    THEN( "a std::runtime_error is thrown when the row is read" ) {
+
+      REQUIRE( reader.nextRow() );
+      REQUIRE_THROWS_AS( reader.nextRow(), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "complete-popu1009-pop.csv can be correctly parsed", "[Areas][authorityByYearCSV]" ) {
+
+  GIVEN( "a newly constructed Areas instance" ) {
+
+    Areas areas = Areas();
+
+    AND_GIVEN( "a valid complete-popu1009-pop.csv file as a memory-mapped file" ) {
+
+      MappedInputFile input("../datasets/complete-popu1009-pop.csv");
+      std::string_view data = input.open();
+
+      AND_GIVEN( "an areasFilter of W06000024 and a yearsFilter of 2011-2012" ) {
+
+        std::unordered_set<std::string> areasFilter{"W06000024"};
+        std::unordered_set<std::string> measuresFilter(0);
+        std::tuple<unsigned int, unsigned int> yearsFilter = std::make_tuple(2011, 2012);
+
+        THEN( "the Areas instance will be populated without exception" ) {
+
+          REQUIRE_NOTHROW( areas.populate(data, BethYw::AuthorityByYearCSV, BethYw::InputFiles::COMPLETE_POP.COLS, &areasFilter, &measuresFilter, &yearsFilter) );
+
+          AND_THEN( "only the filtered area, measure and years are imported" ) {
+
+            REQUIRE( areas.size() == 1 );
+            REQUIRE( areas.getArea("W06000024").size() == 1 );
+            REQUIRE( areas.getArea("W06000024").getMeasure("pop").size() == 2 );
+            REQUIRE( areas.getArea("W06000024").getMeasure("pop").getValue(2011) == 145785 );
+
+          } // AND_THEN
+
+        } // THEN
+
+      } // AND_GIVEN
+
+      AND_GIVEN( "a measuresFilter that does not include pop" ) {
+
+        std::unordered_set<std::string> areasFilter(0);
+        std::unordered_set<std::string> measuresFilter{"dens"};
+        std::tuple<unsigned int, unsigned int> yearsFilter = std::make_tuple(0, 0);
+
+        THEN( "nothing is imported" ) {
+
+          REQUIRE_NOTHROW( areas.populate(data, BethYw::AuthorityByYearCSV, BethYw::InputFiles::COMPLETE_POP.COLS, &areasFilter, &measuresFilter, &yearsFilter) );
+          REQUIRE( areas.size() == 0 );
+
+        } // THEN
+
+      } // AND_GIVEN
+
+    } // AND_GIVEN
+
+  } // GIVEN
+
+} // SCENARIO
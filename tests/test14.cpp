@@ -0,0 +1,184 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <future>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../datasets.h"
+#include "../input.h"
+#include "../threadpool.h"
+
+SCENARIO( "a ThreadPool runs submitted tasks", "[ThreadPool]" ) {
+
+  GIVEN( "a ThreadPool with four threads" ) {
+
+    ThreadPool pool(4);
+
+    REQUIRE( pool.size() == 4 );
+
+    WHEN( "several tasks are submitted" ) {
+
+      std::vector<std::future<int>> results;
+      for(int i = 0; i < 32; i++){
+        results.push_back(pool.submit([i]() { return i * i; }));
+      }
+
+      THEN( "each future holds the result of its own task" ) {
+
+        for(int i = 0; i < 32; i++){
+          REQUIRE( results[i].get() == i * i );
+        }
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a task throws an exception" ) {
+
+      auto result = pool.submit([]() -> int {
+        throw std::runtime_error("task failed");
+      });
+
+      THEN( "the exception is rethrown by the future" ) {
+
+        REQUIRE_THROWS_AS( result.get(), std::runtime_error );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "datasets loaded in parallel match datasets loaded one at a time", "[BethYw][loadDatasets]" ) {
+
+  GIVEN( "all datasets, filtered to two areas and a range of years" ) {
+
+    std::vector<BethYw::InputFileSource> datasets(
+        std::begin(BethYw::InputFiles::DATASETS),
+        std::end(BethYw::InputFiles::DATASETS));
+    StringFilterSet areasFilter{"W06000024", "W06000011"};
+    StringFilterSet measuresFilter(0);
+    YearFilterTuple yearsFilter = std::make_tuple(2005, 2015);
+
+    WHEN( "they are loaded with one thread and with four threads" ) {
+
+      Areas serial = Areas();
+      BethYw::loadAreas(serial, std::string("../datasets") + DIR_SEP, areasFilter);
+      BethYw::loadDatasets(serial, std::string("../datasets") + DIR_SEP, datasets,
+                           areasFilter, measuresFilter, yearsFilter, 1);
+
+      Areas parallel = Areas();
+      BethYw::loadAreas(parallel, std::string("../datasets") + DIR_SEP, areasFilter);
+      BethYw::loadDatasets(parallel, std::string("../datasets") + DIR_SEP, datasets,
+                           areasFilter, measuresFilter, yearsFilter, 4);
+
+      THEN( "the same areas, names and measures are imported" ) {
+
+        REQUIRE( serial.size() == 2 );
+        REQUIRE( parallel.size() == serial.size() );
+        for(const auto& area : serial.getAreasView()){
+          REQUIRE( parallel.getArea(area.first) == area.second );
+        }
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a WelshStatsJSON file parsed on several threads matches a serial parse", "[Areas][WelshStatsJSON]" ) {
+
+  GIVEN( "each WelshStatsJSON dataset as a memory-mapped file" ) {
+
+    THEN( "parsing it on four threads gives the same result as one thread" ) {
+
+      for(const auto& dataset : BethYw::InputFiles::DATASETS){
+        if(dataset.PARSER != BethYw::WelshStatsJSON){
+          continue;
+        }
+
+        MappedInputFile input("../datasets/" + dataset.FILE);
+        std::string_view data = input.open();
+
+        Areas serial = Areas();
+        serial.populate(data, BethYw::WelshStatsJSON, dataset.COLS,
+                        nullptr, nullptr, nullptr, 1);
+
+        Areas parallel = Areas();
+        parallel.populate(data, BethYw::WelshStatsJSON, dataset.COLS,
+                          nullptr, nullptr, nullptr, 4);
+
+        REQUIRE( serial.size() > 0 );
+        REQUIRE( parallel.getAreasView() == serial.getAreasView() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a small WelshStatsJSON document with brackets and quotes inside strings" ) {
+
+    const std::string json = R"({"odata.metadata":"[{\"x\"",)"
+                             R"("value":[)"
+                             R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A, [b]","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":1},)"
+                             R"({"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"C\"}","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":2},)"
+                             R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":3})"
+                             R"(]})";
+    const auto &cols = BethYw::InputFiles::POPDEN.COLS;
+
+    THEN( "parsing it on several threads gives the same result as one thread" ) {
+
+      Areas serial = Areas();
+      serial.populate(json, BethYw::WelshStatsJSON, cols, nullptr, nullptr, nullptr, 1);
+
+      Areas parallel = Areas();
+      parallel.populate(json, BethYw::WelshStatsJSON, cols, nullptr, nullptr, nullptr, 3);
+
+      REQUIRE( serial.size() == 2 );
+      REQUIRE( parallel.getAreasView() == serial.getAreasView() );
+      REQUIRE( parallel.getArea("W1").getName("eng") == "A, [b]" );
+      REQUIRE( parallel.getArea("W1").getMeasure("pop").getValue(2000) == 3 );
+
+    } // THEN
+
+    AND_GIVEN( "a trailing comma in the value array" ) {
+
+      std::string malformed = json;
+      malformed.insert(malformed.size() - 2, ",");
+
+      THEN( "a std::runtime_error is thrown on one thread and on several" ) {
+
+        Areas areas = Areas();
+        REQUIRE_THROWS_AS( areas.populate(malformed, BethYw::WelshStatsJSON, cols, nullptr, nullptr, nullptr, 1), std::runtime_error );
+        REQUIRE_THROWS_AS( areas.populate(malformed, BethYw::WelshStatsJSON, cols, nullptr, nullptr, nullptr, 3), std::runtime_error );
+
+      } // THEN
+
+    } // AND_GIVEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,146 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "../areas.h"
+#include "../datasets.h"
+#include "../input.h"
+#include "../snapshot.h"
+
+SCENARIO( "an Areas instance can be saved to and loaded from a snapshot", "[Snapshot]" ) {
+
+  GIVEN( "an Areas instance populated from areas.csv and popu1009.json" ) {
+
+    Areas areas = Areas();
+
+    MappedInputFile areasInput("../datasets/areas.csv");
+    areas.populate(areasInput.open(), BethYw::AuthorityCodeCSV, BethYw::InputFiles::AREAS.COLS);
+
+    MappedInputFile popInput("../datasets/popu1009.json");
+    areas.populate(popInput.open(), BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS,
+                   nullptr, nullptr, nullptr);
+
+    WHEN( "it is written to a snapshot" ) {
+
+      std::ostringstream os(std::ios::binary);
+      Snapshot::write(os, areas);
+      const std::string snapshot = os.str();
+
+      THEN( "reading the snapshot gives the same areas, names and measures" ) {
+
+        Areas loaded = Areas();
+        REQUIRE_NOTHROW( Snapshot::read(snapshot, loaded) );
+        REQUIRE( loaded.size() == areas.size() );
+        REQUIRE( loaded.getAreasView() == areas.getAreasView() );
+        REQUIRE( loaded.getArea("W06000011").getMeasure("pop").getLabel() ==
+                 areas.getArea("W06000011").getMeasure("pop").getLabel() );
+
+      } // THEN
+
+      THEN( "a truncated snapshot throws a std::runtime_error" ) {
+
+        Areas loaded = Areas();
+        REQUIRE_THROWS_AS( Snapshot::read(std::string_view(snapshot).substr(0, snapshot.size() - 1), loaded), std::runtime_error );
+
+      } // THEN
+
+      THEN( "data that is not a snapshot throws a std::runtime_error" ) {
+
+        Areas loaded = Areas();
+        REQUIRE_THROWS_AS( Snapshot::read("Local authority code,Name (eng)", loaded), std::runtime_error );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a snapshot with corrupt years cannot be loaded", "[Snapshot][corrupt]" ) {
+
+  GIVEN( "a snapshot of one Area with values for 2000 and 2001" ) {
+
+    Areas areas = Areas();
+    Measure measure("pop", "Population");
+    measure.setValue(2000, 1);
+    measure.setValue(2001, 2);
+    Area area("W06000011");
+    area.setMeasure("pop", measure);
+    areas.setArea("W06000011", area);
+
+    std::ostringstream os(std::ios::binary);
+    Snapshot::write(os, areas);
+    std::string snapshot = os.str();
+
+    // the last value is an int32 year followed by a double
+    auto setLastYear = [&snapshot](std::int32_t year) {
+      std::memcpy(&snapshot[snapshot.size() - sizeof(double) - sizeof(year)],
+                  &year, sizeof(year));
+    };
+
+    WHEN( "the last year is before the first" ) {
+
+      setLastYear(1999);
+
+      THEN( "reading it throws a std::runtime_error" ) {
+
+        Areas loaded = Areas();
+        REQUIRE_THROWS_AS( Snapshot::read(snapshot, loaded), std::runtime_error );
+        REQUIRE_THROWS_WITH( Snapshot::read(snapshot, loaded),
+                             "Snapshot::read: Snapshot is corrupt" );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the last year is too far from the first for a Measure" ) {
+
+      setLastYear(2000 + Measure::MAX_YEAR_SPAN);
+
+      THEN( "reading it throws a std::runtime_error" ) {
+
+        Areas loaded = Areas();
+        REQUIRE_THROWS_WITH( Snapshot::read(snapshot, loaded),
+                             "Snapshot::read: Snapshot is corrupt" );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the last year is as far from the first as a Measure allows" ) {
+
+      setLastYear(2000 + Measure::MAX_YEAR_SPAN - 1);
+
+      THEN( "it is read" ) {
+
+        Areas loaded = Areas();
+        REQUIRE_NOTHROW( Snapshot::read(snapshot, loaded) );
+        REQUIRE( loaded.getArea("W06000011").getMeasure("pop").getLastYear()
+                 == 2000 + Measure::MAX_YEAR_SPAN - 1 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,133 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "../lib_json.hpp"
+
+#include "../areas.h"
+#include "../datasets.h"
+#include "../input.h"
+
+using json = nlohmann::json;
+
+// Builds the JSON for an Areas instance as a json object, for comparing with
+// the output of Areas::writeJSON()
+json areasToJSONObject(const Areas& areas) {
+  json j = json::object();
+  for(const auto& area : areas.getAreasView()){
+    json& jArea = j[area.first];
+    jArea["names"] = area.second.getNamesView();
+    for(const auto& measure : area.second.getMeasuresView()){
+      for(const auto& value : measure.second){
+        jArea["measures"][measure.first][std::to_string(value.first)] = value.second;
+      }
+    }
+  }
+  return j;
+}
+
+SCENARIO( "Areas::writeJSON() writes the same JSON as json::dump()", "[Areas][writeJSON]" ) {
+
+  GIVEN( "an empty Areas instance" ) {
+
+    Areas areas = Areas();
+
+    THEN( "the JSON is an empty object" ) {
+
+      std::ostringstream os;
+      areas.writeJSON(os);
+      REQUIRE( os.str() == "{}" );
+      REQUIRE( areas.toJSON() == "{}" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Areas instance populated from areas.csv and econ0080.json" ) {
+
+    Areas areas = Areas();
+
+    MappedInputFile areasInput("../datasets/areas.csv");
+    areas.populate(areasInput.open(), BethYw::AuthorityCodeCSV, BethYw::InputFiles::AREAS.COLS);
+
+    MappedInputFile bizInput("../datasets/econ0080.json");
+    areas.populate(bizInput.open(), BethYw::WelshStatsJSON, BethYw::InputFiles::BIZ.COLS,
+                   nullptr, nullptr, nullptr);
+
+    THEN( "the streamed JSON is byte for byte the same as json::dump()" ) {
+
+      std::ostringstream os;
+      areas.writeJSON(os);
+      REQUIRE( os.str() == areasToJSONObject(areas).dump() );
+      REQUIRE( areas.toJSON() == os.str() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Area with names that need escaping and an awkward set of values" ) {
+
+    Areas areas = Areas();
+    Area area("W06000023");
+    area.setName("eng", "Powys \"County\"\\\n\tTab\x01");
+    area.setName("cym", "Powys Môn");
+    Measure measure("pop", "Population");
+    measure.setValue(999, -0.0);
+    measure.setValue(1000, 1e300);
+    measure.setValue(1001, 0.1);
+    measure.setValue(1002, 12345678);
+    measure.setValue(1003, 1e15);
+    measure.setValue(1004, 1e16);
+    measure.setValue(1005, 0.0001);
+    measure.setValue(1006, -0.00001);
+    measure.setValue(1007, 123456.789e-10);
+    area.setMeasure("pop", measure);
+    areas.setArea("W06000023", area);
+    areas.setArea("W06000024", Area("W06000024"));
+
+    THEN( "the streamed JSON is byte for byte the same as json::dump()" ) {
+
+      std::ostringstream os;
+      areas.writeJSON(os);
+      REQUIRE( os.str() == areasToJSONObject(areas).dump() );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a value that json::dump() writes with more digits than it needs" ) {
+
+    Areas areas = Areas();
+    Area area("W06000023");
+    const double value = 4.1752050594835e+78;
+    area.upsertValue("pop", "Population", 2000, value);
+    areas.setArea("W06000023", area);
+
+    THEN( "it is streamed in the shortest form that reads back as the same double" ) {
+
+      std::ostringstream os;
+      areas.writeJSON(os);
+      REQUIRE( os.str().find("\"2000\":4.1752050594835e+78}") != std::string::npos );
+      REQUIRE( json::parse(os.str())["W06000023"]["measures"]["pop"]["2000"]
+                   .get<double>() == value );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
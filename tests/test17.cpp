@@ -0,0 +1,113 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "../area.h"
+#include "../measure.h"
+
+SCENARIO( "Measure and Area objects are printed as tables", "[Measure][Area][table]" ) {
+
+  GIVEN( "a Measure with three years of values" ) {
+
+    Measure measure("dens", "Population density");
+    measure.setValue(1991, 97.126504);
+    measure.setValue(1992, 97.486216);
+    measure.setValue(1993, 98.038430);
+
+    THEN( "each column is right-aligned to the wider of its header and value" ) {
+
+      std::ostringstream os;
+      os << measure;
+      REQUIRE( os.str() ==
+               "Population density (dens) \n"
+               "     1991      1992      1993   Average    Diff.  % Diff. \n"
+               "97.126504 97.486216 98.038430 97.550383 0.911926 0.938905 \n" );
+
+    } // THEN
+
+    AND_GIVEN( "a stream with its own formatting flags" ) {
+
+      std::ostringstream os;
+      os << std::scientific;
+      os.precision(2);
+      os << measure;
+
+      THEN( "the flags do not change the table" ) {
+
+        REQUIRE( os.str().find("97.550383 0.911926 0.938905 \n") != std::string::npos );
+
+      } // THEN
+
+    } // AND_GIVEN
+
+  } // GIVEN
+
+  GIVEN( "a Measure with no values" ) {
+
+    Measure measure("pop", "Population");
+
+    THEN( "<no data> is printed after the label" ) {
+
+      std::ostringstream os;
+      os << measure;
+      REQUIRE( os.str() == "Population (pop) \n<no data>\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Area with Welsh and English names and no measures" ) {
+
+    Area area("W06000001");
+    area.setName("cym", "Ynys Môn");
+    area.setName("eng", "Isle of Anglesey");
+
+    THEN( "the English name comes first, followed by <no measures>" ) {
+
+      std::ostringstream os;
+      os << area;
+      REQUIRE( os.str() == "Isle of Anglesey / Ynys Môn (W06000001)\n<no measures>\n\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Area with no names and one measure" ) {
+
+    Area area("W06000023");
+    Measure measure("pop", "Population");
+    measure.setValue(2000, 100);
+    measure.setValue(2001, 110);
+    area.setMeasure("pop", measure);
+
+    THEN( "the Area is Unnamed and the measure is followed by a blank line" ) {
+
+      std::ostringstream os;
+      os << area;
+      REQUIRE( os.str() ==
+               "Unnamed (W06000023)\n"
+               "Population (pop) \n"
+               "      2000       2001    Average     Diff.   % Diff. \n"
+               "100.000000 110.000000 105.000000 10.000000 10.000000 \n"
+               "\n" );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
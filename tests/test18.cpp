@@ -0,0 +1,214 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <utility>
+
+#include "../measure.h"
+
+SCENARIO( "a Measure keeps its statistics up to date as values are set", "[Measure][statistics]" ) {
+
+  GIVEN( "a newly constructed Measure" ) {
+
+    Measure measure("pop", "Population");
+
+    THEN( "every statistic is 0" ) {
+
+      REQUIRE( measure.getSum() == 0 );
+      REQUIRE( measure.getMin() == 0 );
+      REQUIRE( measure.getMax() == 0 );
+      REQUIRE( measure.getFirstYear() == 0 );
+      REQUIRE( measure.getLastYear() == 0 );
+      REQUIRE( measure.getAverage() == 0 );
+      REQUIRE( measure.getDifference() == 0 );
+      REQUIRE( measure.getDifferenceAsPercentage() == 0 );
+
+    } // THEN
+
+    WHEN( "values are set in year order" ) {
+
+      measure.setValue(2000, 20);
+      measure.setValue(2001, 10);
+      measure.setValue(2003, 40);
+
+      THEN( "the statistics cover every value" ) {
+
+        REQUIRE( measure.getSum() == 70 );
+        REQUIRE( measure.getMin() == 10 );
+        REQUIRE( measure.getMax() == 40 );
+        REQUIRE( measure.getFirstYear() == 2000 );
+        REQUIRE( measure.getLastYear() == 2003 );
+        REQUIRE( measure.getAverage() == Approx(70.0 / 3) );
+        REQUIRE( measure.getDifference() == 20 );
+        REQUIRE( measure.getDifferenceAsPercentage() == 100 );
+
+      } // THEN
+
+      AND_WHEN( "the minimum and maximum are overwritten" ) {
+
+        measure.setValue(2001, 30);
+        measure.setValue(2003, 25);
+
+        THEN( "the old values no longer count" ) {
+
+          REQUIRE( measure.getSum() == 75 );
+          REQUIRE( measure.getMin() == 20 );
+          REQUIRE( measure.getMax() == 30 );
+          REQUIRE( measure.getAverage() == 25 );
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "values are set before the first year and in a gap" ) {
+
+        measure.setValue(1999, 5);
+        measure.setValue(2002, 50);
+
+        THEN( "the statistics and years include them" ) {
+
+          REQUIRE( measure.getSum() == 125 );
+          REQUIRE( measure.getMin() == 5 );
+          REQUIRE( measure.getMax() == 50 );
+          REQUIRE( measure.getFirstYear() == 1999 );
+          REQUIRE( measure.getLastYear() == 2003 );
+          REQUIRE( measure.getDifference() == 35 );
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "it is merged into an empty Measure" ) {
+
+        Measure merged("pop", "Population");
+        merged.merge(std::move(measure));
+
+        THEN( "the statistics move with the values" ) {
+
+          REQUIRE( merged.getSum() == 70 );
+          REQUIRE( merged.getMin() == 10 );
+          REQUIRE( merged.getMax() == 40 );
+          REQUIRE( measure.getSum() == 0 );
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "it is moved from" ) {
+
+        Measure moved(std::move(measure));
+
+        THEN( "the statistics move with the values" ) {
+
+          REQUIRE( moved.size() == 3 );
+          REQUIRE( moved.getSum() == 70 );
+          REQUIRE( moved.getDifference() == 20 );
+
+        } // THEN
+
+        THEN( "the moved-from Measure has the statistics of an empty one" ) {
+
+          REQUIRE( measure.size() == 0 );
+          REQUIRE( measure.getSum() == 0 );
+          REQUIRE( measure.getMin() == 0 );
+          REQUIRE( measure.getMax() == 0 );
+          REQUIRE( measure.getAverage() == 0 );
+          REQUIRE( measure.getDifference() == 0 );
+          REQUIRE( measure.getDifferenceAsPercentage() == 0 );
+          REQUIRE( measure.begin() == measure.end() );
+
+          AND_THEN( "it can be given new values" ) {
+
+            measure.setValue(1990, 7);
+            REQUIRE( measure.getSum() == 7 );
+            REQUIRE( measure.getFirstYear() == 1990 );
+
+          } // AND_THEN
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "it is move-assigned from" ) {
+
+        Measure assigned("dens", "Density");
+        assigned.setValue(1990, 1);
+        assigned = std::move(measure);
+
+        THEN( "the values and statistics are replaced" ) {
+
+          REQUIRE( assigned.getCodename() == "pop" );
+          REQUIRE( assigned.getSum() == 70 );
+          REQUIRE( assigned.getFirstYear() == 2000 );
+          REQUIRE( measure.size() == 0 );
+          REQUIRE( measure.getDifference() == 0 );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+    WHEN( "values are set out of year order" ) {
+
+      measure.setValue(2003, 40);
+      measure.setValue(2000, 20);
+      measure.setValue(2002, 5);
+      measure.setValue(2001, 10);
+
+      THEN( "the statistics cover every value" ) {
+
+        REQUIRE( measure.getSum() == 75 );
+        REQUIRE( measure.getMin() == 5 );
+        REQUIRE( measure.getMax() == 40 );
+        REQUIRE( measure.getFirstYear() == 2000 );
+        REQUIRE( measure.getLastYear() == 2003 );
+        REQUIRE( measure.getDifference() == 20 );
+
+      } // THEN
+
+      AND_WHEN( "a value between the minimum and maximum is overwritten" ) {
+
+        measure.setValue(2001, 15);
+
+        THEN( "the minimum and maximum are kept" ) {
+
+          REQUIRE( measure.getSum() == 80 );
+          REQUIRE( measure.getMin() == 5 );
+          REQUIRE( measure.getMax() == 40 );
+
+        } // THEN
+
+      } // AND_WHEN
+
+      AND_WHEN( "the minimum is overwritten with a new minimum" ) {
+
+        measure.setValue(2002, 1);
+
+        THEN( "it becomes the minimum" ) {
+
+          REQUIRE( measure.getSum() == 71 );
+          REQUIRE( measure.getMin() == 1 );
+          REQUIRE( measure.getMax() == 40 );
+
+        } // THEN
+
+      } // AND_WHEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,216 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "../stats.h"
+#include "../measure.h"
+#include "../areas.h"
+
+SCENARIO( "the statistics kernels agree with plain loops", "[Stats]" ) {
+
+  GIVEN( "a series of values with some years absent" ) {
+
+    // 150 values spans three mask words and leaves a tail for every lane width
+    const std::size_t n = 150;
+    std::vector<double> values(n, 0);
+    std::vector<std::uint64_t> present(n / 64 + 1, 0);
+    double sum = 0, min = 0, max = 0;
+    int count = 0;
+    for(std::size_t i = 0; i < n; i++){
+      if(i % 3 != 1 && i != 100){
+        values[i] = std::fmod(i * 37.5, 101.0) - 50;
+        present[i / 64] |= std::uint64_t(1) << (i % 64);
+        min = count == 0 ? values[i] : std::min(min, values[i]);
+        max = count == 0 ? values[i] : std::max(max, values[i]);
+        sum += values[i];
+        count++;
+      }
+    }
+    const double mean = sum / count;
+    double squares = 0;
+    for(std::size_t i = 0; i < n; i++){
+      if(i % 3 != 1 && i != 100){
+        squares += (values[i] - mean) * (values[i] - mean);
+      }
+    }
+
+    THEN( "the sum, minimum, maximum and squared deviations match" ) {
+
+      double kernelMin, kernelMax;
+      Stats::minMax(values.data(), present.data(), n, kernelMin, kernelMax);
+      REQUIRE( kernelMin == min );
+      REQUIRE( kernelMax == max );
+      REQUIRE( Stats::sum(values.data(), n) == Approx(sum) );
+      REQUIRE( Stats::sumSquaredDeviations(values.data(), present.data(), n, mean)
+               == Approx(squares) );
+
+    } // THEN
+
+    THEN( "nextPresent() skips every absent value" ) {
+
+      REQUIRE( Stats::nextPresent(present.data(), n, 0) == 0 );
+      REQUIRE( Stats::nextPresent(present.data(), n, 1) == 2 );
+      REQUIRE( Stats::nextPresent(present.data(), n, 100) == 101 );
+      REQUIRE( Stats::nextPresent(present.data(), n, n) == n );
+
+      std::vector<std::uint64_t> none(n / 64 + 1, 0);
+      REQUIRE( Stats::nextPresent(none.data(), n, 0) == n );
+
+    } // THEN
+
+    THEN( "addInto() adds the values to the totals" ) {
+
+      std::vector<double> totals(n, 1);
+      Stats::addInto(totals.data(), values.data(), n);
+      for(std::size_t i = 0; i < n; i++){
+        REQUIRE( totals[i] == values[i] + 1 );
+      }
+
+    } // THEN
+
+    THEN( "combining the Summaries of two halves gives the Summary of the whole" ) {
+
+      std::vector<std::uint64_t> firstHalf(present), secondHalf(present);
+      for(std::size_t i = 0; i < n; i++){
+        (i < 70 ? secondHalf : firstHalf)[i / 64] &= ~(std::uint64_t(1) << (i % 64));
+      }
+
+      auto summarise = [&](const std::vector<std::uint64_t>& mask) {
+        Stats::Summary summary;
+        std::vector<double> masked(n, 0);
+        for(std::size_t i = 0; i < n; i++){
+          if((mask[i / 64] >> (i % 64)) & 1){
+            masked[i] = values[i];
+            summary.count++;
+          }
+        }
+        summary.sum = Stats::sum(masked.data(), n);
+        summary.mean = summary.sum / summary.count;
+        Stats::minMax(masked.data(), mask.data(), n, summary.min, summary.max);
+        summary.variance = Stats::sumSquaredDeviations(
+            masked.data(), mask.data(), n, summary.mean) / summary.count;
+        return summary;
+      };
+
+      Stats::Summary combined = Stats::combine(summarise(firstHalf),
+                                               summarise(secondHalf));
+      REQUIRE( combined.count == count );
+      REQUIRE( combined.sum == Approx(sum) );
+      REQUIRE( combined.min == min );
+      REQUIRE( combined.max == max );
+      REQUIRE( combined.mean == Approx(mean) );
+      REQUIRE( combined.variance == Approx(squares / count) );
+
+      REQUIRE( Stats::combine(Stats::Summary(), combined).count == count );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Measures and Areas can be summarised and totalled", "[Measure][Areas][Stats]" ) {
+
+  GIVEN( "two Measures with overlapping years" ) {
+
+    Measure first("pop", "Population");
+    first.setValue(2000, 1);
+    first.setValue(2002, 3);
+
+    Measure second("pop", "Population");
+    second.setValue(1999, 10);
+    second.setValue(2002, 20);
+
+    THEN( "the variance and Summary are calculated" ) {
+
+      REQUIRE( first.getVariance() == 1 );
+      Stats::Summary summary = first.getSummary();
+      REQUIRE( summary.count == 2 );
+      REQUIRE( summary.sum == 4 );
+      REQUIRE( summary.min == 1 );
+      REQUIRE( summary.max == 3 );
+      REQUIRE( summary.mean == 2 );
+      REQUIRE( summary.variance == 1 );
+      REQUIRE( Measure("pop", "Population").getVariance() == 0 );
+
+    } // THEN
+
+    THEN( "accumulating one into the other adds them year by year" ) {
+
+      first.accumulate(second);
+      REQUIRE( first.size() == 3 );
+      REQUIRE( first.getValue(1999) == 10 );
+      REQUIRE( first.getValue(2000) == 1 );
+      REQUIRE( first.getValue(2002) == 23 );
+      REQUIRE_THROWS_AS( first.getValue(2001), std::out_of_range );
+      REQUIRE( first.getSum() == 34 );
+      REQUIRE( first.getMin() == 1 );
+      REQUIRE( first.getMax() == 23 );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "an Areas instance with a measure in two Areas" ) {
+
+    Areas areas;
+    Area cardiff("W06000015");
+    Measure cardiffPop("pop", "Population");
+    cardiffPop.setValue(2010, 100);
+    cardiffPop.setValue(2011, 200);
+    cardiff.setMeasure("pop", cardiffPop);
+    areas.setArea("W06000015", cardiff);
+
+    Area swansea("W06000011");
+    Measure swanseaPop("pop", "Population");
+    swanseaPop.setValue(2011, 50);
+    swanseaPop.setValue(2012, 70);
+    swansea.setMeasure("pop", swanseaPop);
+    areas.setArea("W06000011", swansea);
+
+    areas.setArea("W06000024", Area("W06000024"));
+
+    THEN( "the measure is totalled across the Areas" ) {
+
+      Measure totals = areas.getMeasureTotals("POP");
+      REQUIRE( totals.getLabel() == "Population" );
+      REQUIRE( totals.size() == 3 );
+      REQUIRE( totals.getValue(2010) == 100 );
+      REQUIRE( totals.getValue(2011) == 250 );
+      REQUIRE( totals.getValue(2012) == 70 );
+
+      REQUIRE( areas.getMeasureTotals("dens").size() == 0 );
+
+    } // THEN
+
+    THEN( "the measure is summarised across the Areas" ) {
+
+      Stats::Summary summary = areas.getMeasureSummary("pop");
+      REQUIRE( summary.count == 4 );
+      REQUIRE( summary.sum == 420 );
+      REQUIRE( summary.min == 50 );
+      REQUIRE( summary.max == 200 );
+      REQUIRE( summary.mean == 105 );
+      REQUIRE( summary.variance == Approx(3325) );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
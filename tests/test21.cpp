@@ -0,0 +1,160 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <future>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../symbol.h"
+#include "../areas.h"
+#include "../datasets.h"
+#include "../input.h"
+
+SCENARIO( "Symbols with the same text share one interned string", "[Symbol]" ) {
+
+  GIVEN( "Symbols created from different string types" ) {
+
+    const std::string text = "W06000011";
+    Symbol fromString(text);
+    Symbol fromView{std::string_view(text)};
+    Symbol fromLiteral("W06000011");
+    Symbol other("W06000015");
+
+    THEN( "they refer to the same string" ) {
+
+      REQUIRE( &fromString.string() == &fromView.string() );
+      REQUIRE( &fromString.string() == &fromLiteral.string() );
+      REQUIRE( fromString == fromLiteral );
+      REQUIRE( fromString != other );
+      REQUIRE( Symbol::isInterned(text) );
+
+    } // THEN
+
+    THEN( "they compare and order by their text against any string type" ) {
+
+      REQUIRE( fromString == text );
+      REQUIRE( "W06000011" == fromString );
+      REQUIRE( fromString != "W06000012" );
+      REQUIRE( fromString < other );
+      REQUIRE( fromString < std::string("W06000012") );
+      REQUIRE_FALSE( other < fromString );
+      REQUIRE( std::string(fromString) == text );
+      REQUIRE( Symbol().empty() );
+      REQUIRE( Symbol("") == Symbol() );
+
+    } // THEN
+
+    THEN( "a map keyed by Symbols is ordered and searched by text" ) {
+
+      std::map<Symbol, int, std::less<>> map;
+      map.emplace(other, 2);
+      map.emplace(fromString, 1);
+      REQUIRE( map.begin()->first == "W06000011" );
+      REQUIRE( map.find(std::string("W06000015"))->second == 2 );
+      REQUIRE( map.find("not a symbol") == map.end() );
+      REQUIRE_FALSE( Symbol::isInterned("not a symbol") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "several threads creating Symbols for the same text" ) {
+
+    std::vector<std::future<const std::string*>> results;
+    for(int i = 0; i < 4; i++){
+      results.push_back(std::async(std::launch::async, []() {
+        const std::string* str = nullptr;
+        for(int j = 0; j < 1000; j++){
+          str = &Symbol("symbol " + std::to_string(j % 50)).string();
+        }
+        return str;
+      }));
+    }
+
+    THEN( "they all get the same string" ) {
+
+      const std::string* first = results[0].get();
+      for(std::size_t i = 1; i < results.size(); i++){
+        REQUIRE( results[i].get() == first );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a SymbolCache" ) {
+
+    SymbolCache symbols;
+    const std::string text = "symbol cache test";
+    const Symbol first = symbols.get(text);
+
+    THEN( "it gives the same Symbols as the symbol table" ) {
+
+      REQUIRE( first == Symbol(text) );
+      REQUIRE( symbols.get(std::string(text)) == first );
+      REQUIRE( symbols.get("") == Symbol() );
+
+    } // THEN
+
+    THEN( "text it has seen is not interned again" ) {
+
+      const std::size_t interned = Symbol::tableSize();
+      for(int i = 0; i < 100; i++){
+        REQUIRE( symbols.get(text) == first );
+      }
+      REQUIRE( Symbol::tableSize() == interned );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Areas share interned codes, codenames and labels", "[Symbol][Areas]" ) {
+
+  GIVEN( "an Areas instance populated from popu1009.json" ) {
+
+    Areas areas = Areas();
+    MappedInputFile popInput("../datasets/popu1009.json");
+    areas.populate(popInput.open(), BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS,
+                   nullptr, nullptr, nullptr);
+
+    THEN( "every Area's Measure refers to the same codename and label" ) {
+
+      const Measure& swansea = areas.getArea("W06000011").getMeasure("pop");
+      const Measure& cardiff = areas.getArea("W06000005").getMeasure("pop");
+      REQUIRE( &swansea.getCodename() == &cardiff.getCodename() );
+      REQUIRE( &swansea.getLabel() == &cardiff.getLabel() );
+      REQUIRE( &areas.getArea("W06000011").getLocalAuthorityCode() ==
+               &Symbol("W06000011").string() );
+
+    } // THEN
+
+    THEN( "populating again does not intern any more strings" ) {
+
+      const std::size_t interned = Symbol::tableSize();
+      Areas again = Areas();
+      again.populate(popInput.open(), BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS,
+                     nullptr, nullptr, nullptr);
+      REQUIRE( Symbol::tableSize() == interned );
+      REQUIRE( again.getAreasView() == areas.getAreasView() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,148 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <memory_resource>
+#include <sstream>
+#include <string>
+#include <utility>
+
+#include "../areas.h"
+#include "../datasets.h"
+#include "../input.h"
+#include "../snapshot.h"
+
+namespace {
+
+/*
+  Makes any allocation from the default memory resource fail while it is in
+  scope, to check that nothing inside an arena-backed Areas uses it.
+*/
+class NoDefaultResource {
+  public:
+    NoDefaultResource()
+        : previous(std::pmr::set_default_resource(std::pmr::null_memory_resource())) {}
+
+    ~NoDefaultResource() {
+      std::pmr::set_default_resource(previous);
+    }
+
+  private:
+    std::pmr::memory_resource* previous;
+};
+
+void populate(Areas& areas) {
+  MappedInputFile areasInput("../datasets/areas.csv");
+  areas.populate(areasInput.open(), BethYw::AuthorityCodeCSV, BethYw::InputFiles::AREAS.COLS);
+
+  MappedInputFile popInput("../datasets/popu1009.json");
+  areas.populate(popInput.open(), BethYw::WelshStatsJSON, BethYw::InputFiles::POPDEN.COLS,
+                 nullptr, nullptr, nullptr);
+}
+
+} // namespace
+
+SCENARIO( "an Areas instance can allocate everything from its own arena", "[Areas][arena]" ) {
+
+  GIVEN( "an Areas instance populated on the heap" ) {
+
+    Areas heap = Areas();
+    populate(heap);
+
+    THEN( "it does not use an arena" ) {
+
+      REQUIRE_FALSE( heap.usesArena() );
+      REQUIRE( heap.getResource() == std::pmr::get_default_resource() );
+
+    } // THEN
+
+    WHEN( "an Areas instance with an arena is populated from the same files" ) {
+
+      Areas arena(Areas::Arena);
+      {
+        NoDefaultResource guard;
+        REQUIRE_NOTHROW( populate(arena) );
+      }
+
+      THEN( "it holds the same data, allocated from its arena" ) {
+
+        REQUIRE( arena.usesArena() );
+        REQUIRE( arena.getResource() != std::pmr::get_default_resource() );
+        REQUIRE( arena.getAreasView() == heap.getAreasView() );
+
+        // names too long to be stored inside the string are in the arena
+        const auto& names = arena.getArea("W06000001").getNamesView();
+        REQUIRE( names.at("eng") == "Isle of Anglesey" );
+        REQUIRE( names.at("eng").get_allocator().resource() == arena.getResource() );
+        REQUIRE( names.at("cym").get_allocator().resource() == arena.getResource() );
+
+      } // THEN
+
+      THEN( "moving it keeps the arena, and copying it gives an equal copy" ) {
+
+        Areas moved(std::move(arena));
+        REQUIRE( moved.usesArena() );
+        REQUIRE( moved.getAreasView() == heap.getAreasView() );
+
+        Areas copy(moved);
+        REQUIRE( copy.usesArena() );
+        REQUIRE( copy.getResource() != moved.getResource() );
+        REQUIRE( copy.getAreasView() == heap.getAreasView() );
+
+        Areas assigned = Areas();
+        assigned = std::move(copy);
+        REQUIRE_FALSE( assigned.usesArena() );
+        REQUIRE( assigned.getAreasView() == heap.getAreasView() );
+
+      } // THEN
+
+      THEN( "it can be saved to and loaded from a snapshot in an arena" ) {
+
+        std::ostringstream os(std::ios::binary);
+        Snapshot::write(os, arena);
+        const std::string snapshot = os.str();
+
+        Areas loaded(Areas::Arena);
+        {
+          NoDefaultResource guard;
+          REQUIRE_NOTHROW( Snapshot::read(snapshot, loaded) );
+        }
+        REQUIRE( loaded.getAreasView() == heap.getAreasView() );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "an Areas instance sharing another's arena is merged into it" ) {
+
+      Areas arena(Areas::Arena);
+      {
+        NoDefaultResource guard;
+        Areas partial(arena.getResource());
+        populate(partial);
+        arena.merge(std::move(partial));
+      }
+
+      THEN( "the merged Areas hold the same data" ) {
+
+        REQUIRE( arena.getAreasView() == heap.getAreasView() );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
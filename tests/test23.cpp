@@ -0,0 +1,111 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../areas.h"
+#include "../symbol.h"
+
+SCENARIO( "Areas are found by hash and viewed in order", "[Areas][AreasView]" ) {
+
+  GIVEN( "an Areas instance with Areas added out of order" ) {
+
+    Areas areas = Areas();
+    areas.setArea("W06000015", Area("W06000015"));
+    areas.findOrCreateArea(Symbol("W06000001"));
+    areas.setArea("W06000011", Area("W06000011"));
+
+    THEN( "the view lists them in order of local authority code" ) {
+
+      std::vector<std::string> codes;
+      for(const auto& area : areas.getAreasView()){
+        codes.push_back(area.first);
+      }
+      REQUIRE( codes == std::vector<std::string>{"W06000001", "W06000011", "W06000015"} );
+      REQUIRE( areas.getAreasView().size() == 3 );
+
+    } // THEN
+
+    THEN( "the view is brought up to date when an Area is added" ) {
+
+      REQUIRE( areas.getAreasView().size() == 3 );
+      areas.findOrCreateArea(Symbol("W06000005"));
+      REQUIRE( areas.getAreasView().size() == 4 );
+      REQUIRE( (++areas.getAreasView().begin())->first == "W06000005" );
+
+      // finding an existing Area does not add another
+      areas.findOrCreateArea(Symbol("W06000005"));
+      REQUIRE( areas.getAreasView().size() == 4 );
+
+    } // THEN
+
+    THEN( "looking up a code that was never interned does not intern it" ) {
+
+      REQUIRE_THROWS_AS( areas.getArea("W99999998"), std::out_of_range );
+      REQUIRE_FALSE( Symbol::isInterned("W99999998") );
+      REQUIRE( areas.getArea("W06000011").getLocalAuthorityCode() == "W06000011" );
+
+    } // THEN
+
+    THEN( "views of Areas with the same contents are equal" ) {
+
+      Areas other = Areas();
+      other.setArea("W06000011", Area("W06000011"));
+      other.setArea("W06000001", Area("W06000001"));
+      REQUIRE_FALSE( other.getAreasView() == areas.getAreasView() );
+      other.setArea("W06000015", Area("W06000015"));
+      REQUIRE( other.getAreasView() == areas.getAreasView() );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "Measures and values are found with a single lookup", "[Area][Measure]" ) {
+
+  GIVEN( "an Area with a Measure" ) {
+
+    Area area("W06000011");
+    area.upsertValue("Pop", "Population", 2010, 1);
+    area.upsertValue("pop", "Population", 2012, 3);
+
+    THEN( "findMeasure() finds it in any case, or returns nullptr" ) {
+
+      REQUIRE( area.findMeasure("POP") == &area.getMeasure("pop") );
+      REQUIRE( area.findMeasure("dens") == nullptr );
+      REQUIRE( area.checkMeasure("Pop") );
+      REQUIRE_FALSE( area.checkMeasure("dens") );
+
+    } // THEN
+
+    THEN( "getValue() checks every year around the stored ones" ) {
+
+      const Measure& pop = area.getMeasure("pop");
+      REQUIRE( pop.getValue(2010) == 1 );
+      REQUIRE( pop.getValue(2012) == 3 );
+      REQUIRE_THROWS_AS( pop.getValue(2009), std::out_of_range );
+      REQUIRE_THROWS_AS( pop.getValue(2011), std::out_of_range );
+      REQUIRE_THROWS_AS( pop.getValue(2013), std::out_of_range );
+      REQUIRE_THROWS_AS( pop.getValue(-2147483647 - 1), std::out_of_range );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
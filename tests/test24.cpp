@@ -0,0 +1,250 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <unordered_set>
+
+#include "../areas.h"
+#include "../datasets.h"
+#include "../input.h"
+
+SCENARIO( "WelshStatsJSON rows are filtered before they are converted", "[Areas][populateFromWelshStatsJSON]" ) {
+
+  GIVEN( "a WelshStatsJSON document whose filtered-out rows have bad values" ) {
+
+    // the rows for W2 and for 2001 could not be converted if they were kept
+    const std::string json = R"({"value":[)"
+                             R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":"1.5"},)"
+                             R"({"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"B","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"20x0","Data":"n/a"},)"
+                             R"({"Year_Code":"2001","Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Data":"n/a"},)"
+                             R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Dens","Measure_ItemName_ENG":"Density","Year_Code":2000,"Data":"n/a"})"
+                             R"(]})";
+    const auto &cols = BethYw::InputFiles::POPDEN.COLS;
+
+    const StringFilterSet areasFilter = {"W1"};
+    const StringFilterSet measuresFilter = {"pop"};
+    const YearFilterTuple yearsFilter(1990, 2000);
+
+    THEN( "only the rows that pass every filter are converted and inserted" ) {
+
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_NOTHROW( areas.populateFromWelshStatsJSON(stream, cols, &areasFilter, &measuresFilter, &yearsFilter) );
+
+      REQUIRE( areas.size() == 1 );
+      REQUIRE( areas.getArea("W1").size() == 1 );
+      REQUIRE( areas.getArea("W1").getMeasure("pop").size() == 1 );
+      REQUIRE( areas.getArea("W1").getMeasure("pop").getValue(2000) == 1.5 );
+
+    } // THEN
+
+    THEN( "without the filters the bad values are reported" ) {
+
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(stream, cols, nullptr, nullptr, nullptr), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a WelshStatsJSON document with a row that is filtered out and missing a column" ) {
+
+    const std::string json = R"({"value":[)"
+                             R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":1},)"
+                             R"({"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"B","Measure_Code":"Pop","Year_Code":"2000","Data":2})"
+                             R"(]})";
+    const StringFilterSet areasFilter = {"W1"};
+
+    THEN( "a std::runtime_error is still thrown" ) {
+
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(stream, BethYw::InputFiles::POPDEN.COLS, &areasFilter, nullptr, nullptr), std::runtime_error );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a WelshStatsJSON document with a single measure" ) {
+
+    const std::string json = R"({"value":[)"
+                             R"({"LocalAuthority_Code":"W1","LocalAuthority_ItemName_ENG":"A","Year_Code":"2000","Data":"n/a"})"
+                             R"(]})";
+    const auto &cols = BethYw::InputFiles::TRAINS.COLS;
+
+    THEN( "a measures filter without it rejects every row" ) {
+
+      const StringFilterSet measuresFilter = {"pop"};
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_NOTHROW( areas.populateFromWelshStatsJSON(stream, cols, nullptr, &measuresFilter, nullptr) );
+      REQUIRE( areas.size() == 0 );
+
+    } // THEN
+
+    THEN( "a measures filter with it keeps every row" ) {
+
+      const StringFilterSet measuresFilter = {"rail"};
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(stream, cols, nullptr, &measuresFilter, nullptr), std::invalid_argument );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "malformed WelshStatsJSON documents are reported", "[Areas][populateFromWelshStatsJSON]" ) {
+
+  const auto &cols = BethYw::InputFiles::POPDEN.COLS;
+  const std::string prefix = "Areas::populateFromWelshStatsJSON: ";
+  const std::string goodRow = R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":1})";
+
+  GIVEN( "a WelshStatsJSON document that is not valid JSON" ) {
+
+    const std::string json = R"({"value":[)" + goodRow + R"(,{"Localauthority_Code":"W2",)";
+
+    THEN( "a std::runtime_error is thrown with the parser's message" ) {
+
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(stream, cols, nullptr, nullptr, nullptr), std::runtime_error );
+
+      std::istringstream again(json);
+      REQUIRE_THROWS_WITH( areas.populateFromWelshStatsJSON(again, cols, nullptr, nullptr, nullptr),
+                           Catch::Matchers::StartsWith(prefix + "[json.exception.parse_error.") );
+
+    } // THEN
+
+    THEN( "the same is thrown when it is parsed on several threads" ) {
+
+      Areas areas = Areas();
+      REQUIRE_THROWS_WITH( areas.populateFromWelshStatsJSON(std::string_view(json), cols, nullptr, nullptr, nullptr, 2),
+                           Catch::Matchers::StartsWith(prefix + "[json.exception.parse_error.") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a WelshStatsJSON document with a row that is missing a column" ) {
+
+    const std::string json = R"({"value":[)" + goodRow +
+                             R"(,{"Localauthority_Code":"W2","Localauthority_ItemName_ENG":"B","Measure_Code":"Pop","Year_Code":"2000","Data":2})"
+                             R"(]})";
+    const std::string exceptionMessage = prefix + "Row is missing a column";
+
+    THEN( "a std::runtime_error is thrown with message " + exceptionMessage ) {
+
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(stream, cols, nullptr, nullptr, nullptr), std::runtime_error );
+
+      std::istringstream again(json);
+      REQUIRE_THROWS_WITH( areas.populateFromWelshStatsJSON(again, cols, nullptr, nullptr, nullptr), exceptionMessage );
+
+    } // THEN
+
+    THEN( "the same is thrown when it is parsed on several threads" ) {
+
+      Areas areas = Areas();
+      REQUIRE_THROWS_WITH( areas.populateFromWelshStatsJSON(std::string_view(json), cols, nullptr, nullptr, nullptr, 2),
+                           exceptionMessage );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "WelshStatsJSON documents with values of the wrong type" ) {
+
+    THEN( "a value that is neither a number nor a string counts as a missing column" ) {
+
+      const std::string json = R"({"value":[)"
+                               R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":true})"
+                               R"(]})";
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_THROWS_WITH( areas.populateFromWelshStatsJSON(stream, cols, nullptr, nullptr, nullptr),
+                           prefix + "Row is missing a column" );
+
+    } // THEN
+
+    THEN( "a year that is an object counts as a missing column" ) {
+
+      const std::string json = R"({"value":[)"
+                               R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":{"Year":2000},"Data":1})"
+                               R"(]})";
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_THROWS_WITH( areas.populateFromWelshStatsJSON(stream, cols, nullptr, nullptr, nullptr),
+                           prefix + "Row is missing a column" );
+
+    } // THEN
+
+    THEN( "a numeric year that is not a whole number within the range of int throws a std::runtime_error" ) {
+
+      const std::string exceptionMessage = prefix + "Year is not a whole number";
+      for(const std::string year : {"2015.7", "1e10", "-3e9", "18446744073709551615"}){
+        const std::string json = R"({"value":[)"
+                                 R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":)" + year + R"(,"Data":1})"
+                                 R"(]})";
+        std::istringstream stream(json);
+        Areas areas = Areas();
+        REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(stream, cols, nullptr, nullptr, nullptr), std::runtime_error );
+
+        std::istringstream again(json);
+        REQUIRE_THROWS_WITH( areas.populateFromWelshStatsJSON(again, cols, nullptr, nullptr, nullptr), exceptionMessage );
+      }
+
+    } // THEN
+
+    THEN( "a numeric year written with a fraction of zero is read as a whole year" ) {
+
+      const std::string json = R"({"value":[)"
+                               R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":2015.0,"Data":1})"
+                               R"(]})";
+      std::istringstream stream(json);
+      Areas areas = Areas();
+      REQUIRE_NOTHROW( areas.populateFromWelshStatsJSON(stream, cols, nullptr, nullptr, nullptr) );
+      REQUIRE( areas.getArea("W1").getMeasure("pop").getValue(2015) == 1 );
+
+    } // THEN
+
+    THEN( "a year or value string that is not a number throws a std::invalid_argument" ) {
+
+      const std::string badYear = R"({"value":[)"
+                                  R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"year","Data":1})"
+                                  R"(]})";
+      const std::string badValue = R"({"value":[)"
+                                   R"({"Localauthority_Code":"W1","Localauthority_ItemName_ENG":"A","Measure_Code":"Pop","Measure_ItemName_ENG":"Population","Year_Code":"2000","Data":"value"})"
+                                   R"(]})";
+      std::istringstream yearStream(badYear);
+      std::istringstream valueStream(badValue);
+      Areas areas = Areas();
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(yearStream, cols, nullptr, nullptr, nullptr), std::invalid_argument );
+      REQUIRE_THROWS_AS( areas.populateFromWelshStatsJSON(valueStream, cols, nullptr, nullptr, nullptr), std::invalid_argument );
+      REQUIRE( areas.size() == 0 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,162 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <string>
+#include <tuple>
+#include <unordered_set>
+
+#include "../areas.h"
+#include "../datasets.h"
+#include "../filter.h"
+#include "../input.h"
+
+SCENARIO( "a FilterSpec accepts exactly what its filters allow", "[FilterSpec]" ) {
+
+  GIVEN( "a FilterSpec built with no filters" ) {
+
+    const FilterSpec filter;
+    const StringFilterSet empty;
+    const YearFilterTuple allYears(0, 0);
+    const FilterSpec alsoAll(&empty, &empty, &allYears);
+
+    THEN( "everything is accepted" ) {
+
+      REQUIRE_FALSE( filter.filtersAreas() );
+      REQUIRE_FALSE( filter.filtersMeasures() );
+      REQUIRE_FALSE( filter.filtersYears() );
+      REQUIRE( filter.accepts("W06000011", "pop", 2015) );
+      REQUIRE( filter.accepts("", "", -5) );
+
+      REQUIRE_FALSE( alsoAll.filtersYears() );
+      REQUIRE( alsoAll.accepts("W06000011", "pop", 0) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a FilterSpec with area, measure and year filters" ) {
+
+    const StringFilterSet areasFilter = {"W06000011", "W06000024", ""};
+    const StringFilterSet measuresFilter = {"pop"};
+    const YearFilterTuple yearsFilter(2010, 2015);
+    const FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+
+    THEN( "each filter is applied" ) {
+
+      REQUIRE( filter.filtersAreas() );
+      REQUIRE( filter.filtersMeasures() );
+      REQUIRE( filter.filtersYears() );
+
+      REQUIRE( filter.accepts("W06000011", "pop", 2010) );
+      REQUIRE( filter.accepts("W06000024", "pop", 2015) );
+      REQUIRE( filter.acceptsArea("") );
+      REQUIRE_FALSE( filter.acceptsArea("W0600001") );
+      REQUIRE_FALSE( filter.acceptsArea("W060000110") );
+      REQUIRE_FALSE( filter.accepts("W06000001", "pop", 2012) );
+      REQUIRE_FALSE( filter.accepts("W06000011", "dens", 2012) );
+      REQUIRE_FALSE( filter.accepts("W06000011", "pop", 2009) );
+      REQUIRE_FALSE( filter.accepts("W06000011", "pop", 2016) );
+      REQUIRE_FALSE( filter.acceptsYear(-2010) );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a FilterSpec with many areas" ) {
+
+    StringFilterSet areasFilter;
+    for(int i = 0; i < 500; i++){
+      areasFilter.insert("W" + std::to_string(6000000 + i * 7));
+    }
+    const FilterSpec filter(&areasFilter, nullptr, nullptr);
+
+    THEN( "every area is accepted and no other" ) {
+
+      for(int i = 0; i < 500 * 7; i++){
+        const std::string code = "W" + std::to_string(6000000 + i);
+        REQUIRE( filter.acceptsArea(code) == (i % 7 == 0) );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a FilterSpec with measures that share a prefix" ) {
+
+    const StringFilterSet measuresFilter = {"", "a", "aa", "aaa", "ab"};
+    const FilterSpec filter(nullptr, &measuresFilter, nullptr);
+
+    THEN( "each is accepted, but not their other prefixes" ) {
+
+      for(const auto& measure : measuresFilter){
+        REQUIRE( filter.acceptsMeasure(measure) );
+      }
+      REQUIRE_FALSE( filter.acceptsMeasure("aaaa") );
+      REQUIRE_FALSE( filter.acceptsMeasure("b") );
+      REQUIRE_FALSE( filter.acceptsMeasure("ba") );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a FilterSpec with a year range that ends before it starts" ) {
+
+    const YearFilterTuple yearsFilter(2015, 2010);
+    const FilterSpec filter(nullptr, nullptr, &yearsFilter);
+
+    THEN( "no year is accepted" ) {
+
+      REQUIRE( filter.filtersYears() );
+      REQUIRE_FALSE( filter.acceptsYear(2010) );
+      REQUIRE_FALSE( filter.acceptsYear(2012) );
+      REQUIRE_FALSE( filter.acceptsYear(2015) );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "populating with a FilterSpec matches populating with the filters", "[Areas][FilterSpec]" ) {
+
+  GIVEN( "each dataset and the same filters in both forms" ) {
+
+    const StringFilterSet areasFilter = {"W06000011", "W06000024"};
+    const StringFilterSet measuresFilter = {"pop", "dens", "rail", "no2"};
+    const YearFilterTuple yearsFilter(2005, 2015);
+    const FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+
+    THEN( "the same Areas are imported" ) {
+
+      for(const auto& dataset : BethYw::InputFiles::DATASETS){
+        MappedInputFile input(std::string("../datasets/") + dataset.FILE);
+        const auto data = input.open();
+
+        Areas expected = Areas();
+        expected.populate(data, dataset.PARSER, dataset.COLS,
+                          &areasFilter, &measuresFilter, &yearsFilter);
+
+        Areas actual = Areas();
+        actual.populate(data, dataset.PARSER, dataset.COLS, filter);
+
+        REQUIRE( actual.getAreasView() == expected.getAreasView() );
+      }
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
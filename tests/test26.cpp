@@ -0,0 +1,362 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "../lib_cxxopts.hpp"
+#include "../lib_cxxopts_argv.hpp"
+#include "../lib_json.hpp"
+
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../datasets.h"
+#include "../runstats.h"
+
+SCENARIO( "the stats program argument can be parsed", "[args][stats]" ) {
+
+  auto cxxopts = BethYw::cxxoptsSetup();
+
+  WHEN( "it is not given" ) {
+
+    Argv argv({"test"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+    auto args          = cxxopts.parse(argc, actual_argv);
+
+    THEN( "no statistics are asked for" ) {
+
+      REQUIRE( BethYw::parseStatsArg(args) == "" );
+
+    } // THEN
+
+  } // WHEN
+
+  WHEN( "it is given on its own" ) {
+
+    Argv argv({"test", "--stats"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+    auto args          = cxxopts.parse(argc, actual_argv);
+
+    THEN( "the statistics are asked for as text" ) {
+
+      REQUIRE( BethYw::parseStatsArg(args) == "text" );
+
+    } // THEN
+
+  } // WHEN
+
+  WHEN( "it is given as json" ) {
+
+    Argv argv({"test", "--stats=JSON"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+    auto args          = cxxopts.parse(argc, actual_argv);
+
+    THEN( "the statistics are asked for as JSON" ) {
+
+      REQUIRE( BethYw::parseStatsArg(args) == "json" );
+
+    } // THEN
+
+  } // WHEN
+
+  WHEN( "it is given an unknown format" ) {
+
+    Argv argv({"test", "--stats=xml"});
+    auto** actual_argv = argv.argv();
+    auto argc          = argv.argc();
+    auto args          = cxxopts.parse(argc, actual_argv);
+
+    THEN( "an exception is thrown" ) {
+
+      REQUIRE_THROWS_AS( BethYw::parseStatsArg(args), std::invalid_argument );
+      REQUIRE_THROWS_WITH( BethYw::parseStatsArg(args),
+                           "Invalid input for stats argument" );
+
+    } // THEN
+
+  } // WHEN
+
+} // SCENARIO
+
+SCENARIO( "a RunStats records its phases", "[RunStats]" ) {
+
+  GIVEN( "a RunStats with two timed phases" ) {
+
+    RunStats stats;
+    {
+      RunStats::Timer timer(&stats, "first");
+      std::vector<int> allocated(1000, 1);
+      timer.counters().rowsParsed = 10;
+      timer.counters().rowsFiltered = 4;
+    }
+    {
+      RunStats::Timer timer(&stats, "first/inner");
+      timer.counters().rowsParsed = 100;
+      timer.stop();
+      timer.counters().rowsParsed = 1000; // too late to be recorded
+    }
+    RunStats::Timer ignored(nullptr, "ignored");
+    ignored.stop();
+
+    THEN( "each phase is recorded once, in the order they finished" ) {
+
+      auto phases = stats.getPhases();
+      REQUIRE( phases.size() == 2 );
+      REQUIRE( phases[0].name == "first" );
+      REQUIRE( phases[0].counters.rowsParsed == 10 );
+      REQUIRE( phases[0].counters.rowsFiltered == 4 );
+      if(RunStats::COUNTS_ALLOCATIONS){
+        REQUIRE( phases[0].allocations >= 1 );
+        REQUIRE( phases[0].allocatedBytes >= 1000 * sizeof(int) );
+      }else{
+        REQUIRE( phases[0].allocations == 0 );
+        REQUIRE( phases[0].allocatedBytes == 0 );
+      }
+      REQUIRE( phases[0].wallSeconds >= 0 );
+      REQUIRE( phases[1].name == "first/inner" );
+      REQUIRE( phases[1].counters.rowsParsed == 100 );
+
+    } // THEN
+
+    THEN( "the total only adds up the counters of top-level phases" ) {
+
+      auto total = stats.getTotal();
+      REQUIRE( total.name == "total" );
+      REQUIRE( total.counters.rowsParsed == 10 );
+      REQUIRE( total.counters.rowsFiltered == 4 );
+      REQUIRE( total.wallSeconds >= stats.getPhases()[0].wallSeconds );
+
+    } // THEN
+
+    THEN( "they can be written as a table" ) {
+
+      std::stringstream text;
+      stats.writeText(text);
+      std::string line;
+      std::vector<std::string> lines;
+      while(std::getline(text, line)){
+        lines.push_back(line);
+      }
+      REQUIRE( lines.size() == 4 );
+      REQUIRE( lines[0].rfind("phase", 0) == 0 );
+      REQUIRE( lines[1].rfind("first ", 0) == 0 );
+      REQUIRE( lines[2].rfind("first/inner ", 0) == 0 );
+      REQUIRE( lines[3].rfind("total ", 0) == 0 );
+
+    } // THEN
+
+    THEN( "they can be written as JSON" ) {
+
+      std::stringstream text;
+      stats.writeJSON(text);
+      auto output = nlohmann::json::parse(text.str());
+      REQUIRE( output["phases"].size() == 2 );
+      REQUIRE( output["phases"][0]["name"] == "first" );
+      REQUIRE( output["phases"][0]["counters"]["rows_parsed"] == 10 );
+      REQUIRE( output["phases"][1]["counters"]["rows_parsed"] == 100 );
+      REQUIRE( output["total"]["counters"]["rows_filtered"] == 4 );
+      REQUIRE( output["total"].contains("peak_rss_bytes") );
+      REQUIRE( output["phases"][0]["allocations"].is_null()
+               == !RunStats::COUNTS_ALLOCATIONS );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "importing datasets counts the rows read and filtered out",
+          "[Areas][RunStats]" ) {
+
+  const std::string dir = "../datasets/";
+
+  GIVEN( "the areas file and the popden and trains datasets" ) {
+
+    std::vector<BethYw::InputFileSource> datasets;
+    for(const auto& dataset : BethYw::InputFiles::DATASETS){
+      if(dataset.CODE == "popden" || dataset.CODE == "trains"){
+        datasets.push_back(dataset);
+      }
+    }
+    REQUIRE( datasets.size() == 2 );
+
+    const StringFilterSet areasFilter = {"W06000011"};
+    const StringFilterSet measuresFilter;
+    const YearFilterTuple yearsFilter(0, 0);
+    const FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+
+    auto checkImport = [&](unsigned int threads) {
+      RunStats stats;
+      Areas areas(Areas::Arena);
+      BethYw::loadAreas(areas, dir, filter, &stats);
+      REQUIRE( BethYw::loadDatasets(areas, dir, datasets, filter, threads,
+                                    &stats) );
+
+      auto phases = stats.getPhases();
+      auto find = [&phases](const std::string& name) {
+        for(const auto& phase : phases){
+          if(phase.name == name){
+            return phase;
+          }
+        }
+        FAIL( "no phase named " << name );
+        return RunStats::Phase();
+      };
+
+      auto areasPhase = find("areas");
+      REQUIRE( areasPhase.counters.rowsParsed == 22 );
+      REQUIRE( areasPhase.counters.rowsFiltered == 21 );
+      REQUIRE( areasPhase.counters.areasCreated == 1 );
+      REQUIRE( areasPhase.counters.bytesRead > 0 );
+
+      auto popden = find("datasets/popden");
+      auto trains = find("datasets/trains");
+      auto all = find("datasets");
+      REQUIRE( popden.counters.rowsParsed > popden.counters.rowsFiltered );
+      REQUIRE( popden.counters.rowsFiltered > 0 );
+      REQUIRE( all.counters.rowsParsed
+               == popden.counters.rowsParsed + trains.counters.rowsParsed );
+      REQUIRE( all.counters.rowsFiltered
+               == popden.counters.rowsFiltered + trains.counters.rowsFiltered );
+      REQUIRE( all.counters.bytesRead
+               == popden.counters.bytesRead + trains.counters.bytesRead );
+
+      // nothing new is created by merging into the Area already named
+      REQUIRE( all.counters.areasCreated == 0 );
+      REQUIRE( all.counters.measuresCreated
+               == popden.counters.measuresCreated
+                  + trains.counters.measuresCreated );
+      REQUIRE( all.counters.valuesCreated
+               == BethYw::countContents(areas).valuesCreated );
+
+      REQUIRE( areas.getImportCounts().rowsParsed
+               == areasPhase.counters.rowsParsed + all.counters.rowsParsed );
+    };
+
+    WHEN( "they are imported one after another with statistics" ) {
+
+      THEN( "every row is counted, and those filtered out are counted "
+            "separately" ) {
+
+        checkImport(1);
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "they are imported in parallel with statistics" ) {
+
+      THEN( "the counts are the same" ) {
+
+        checkImport(2);
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "they are imported without statistics" ) {
+
+      Areas areas(Areas::Arena);
+      BethYw::loadAreas(areas, dir, FilterSpec());
+
+      THEN( "the rows are still counted by the Areas" ) {
+
+        REQUIRE( areas.getImportCounts().rowsParsed == 22 );
+        REQUIRE( areas.getImportCounts().rowsFiltered == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "rows filtered out before any of their values are read are counted",
+          "[Areas][RunStats]" ) {
+
+  GIVEN( "the complete-pop dataset as an open std::istream" ) {
+
+    const std::string file =
+        "../datasets/" + BethYw::InputFiles::COMPLETE_POP.FILE;
+    std::ifstream stream(file);
+    REQUIRE( stream.is_open() );
+
+    const StringFilterSet noAreas;
+    const StringFilterSet noMeasures;
+    const YearFilterTuple allYears(0, 0);
+
+    Areas areas = Areas();
+
+    WHEN( "its measure is filtered out" ) {
+
+      const StringFilterSet measuresFilter = {"nonexist"};
+      areas.populate(stream, BethYw::AuthorityByYearCSV,
+                     BethYw::InputFiles::COMPLETE_POP.COLS,
+                     FilterSpec(&noAreas, &measuresFilter, &allYears));
+
+      THEN( "every row is counted as parsed and filtered out" ) {
+
+        REQUIRE( areas.size() == 0 );
+        REQUIRE( areas.getImportCounts().rowsParsed == 22 );
+        REQUIRE( areas.getImportCounts().rowsFiltered == 22 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "every one of its years is filtered out" ) {
+
+      const YearFilterTuple yearsFilter(1900, 1950);
+      areas.populate(stream, BethYw::AuthorityByYearCSV,
+                     BethYw::InputFiles::COMPLETE_POP.COLS,
+                     FilterSpec(&noAreas, &noMeasures, &yearsFilter));
+
+      THEN( "every row is counted as parsed and filtered out" ) {
+
+        REQUIRE( areas.size() == 0 );
+        REQUIRE( areas.getImportCounts().rowsParsed == 22 );
+        REQUIRE( areas.getImportCounts().rowsFiltered == 22 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "only some of its years are filtered out" ) {
+
+      const YearFilterTuple yearsFilter(2011, 2011);
+      areas.populate(stream, BethYw::AuthorityByYearCSV,
+                     BethYw::InputFiles::COMPLETE_POP.COLS,
+                     FilterSpec(&noAreas, &noMeasures, &yearsFilter));
+
+      THEN( "no row is counted as filtered out" ) {
+
+        REQUIRE( areas.size() == 22 );
+        REQUIRE( areas.getImportCounts().rowsParsed == 22 );
+        REQUIRE( areas.getImportCounts().rowsFiltered == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,199 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "../lib_json.hpp"
+
+#include "../trace.h"
+
+namespace {
+
+nlohmann::json writeTrace() {
+  std::stringstream text;
+  Trace::writeChromeJSON(text);
+  return nlohmann::json::parse(text.str());
+}
+
+} // namespace
+
+SCENARIO( "spans are only recorded while tracing is started", "[Trace]" ) {
+
+  GIVEN( "tracing that has been stopped" ) {
+
+    Trace::start();
+    Trace::stop();
+
+    WHEN( "a span ends" ) {
+
+      { Trace::Span span("test::stopped"); }
+
+      THEN( "nothing is recorded" ) {
+
+        REQUIRE_FALSE( Trace::isRecording() );
+        REQUIRE( Trace::size() == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "tracing that has been started" ) {
+
+    Trace::start();
+
+    WHEN( "spans end on two threads" ) {
+
+      {
+        Trace::Span outer("test::outer", "some detail");
+        { Trace::Span inner("test::inner"); }
+      }
+      std::thread other([]() { Trace::Span span("test::thread"); });
+      other.join();
+      Trace::stop();
+
+      THEN( "they are written as complete Chrome trace events" ) {
+
+        REQUIRE( Trace::size() == 3 );
+        REQUIRE( Trace::dropped() == 0 );
+
+        auto output = writeTrace();
+        REQUIRE( output["otherData"]["dropped_spans"] == 0 );
+
+        std::set<int> threads;
+        nlohmann::json outer, inner, thread;
+        for(const auto& event : output["traceEvents"]){
+          if(event["ph"] == "M"){
+            REQUIRE( event["name"] == "thread_name" );
+            continue;
+          }
+          REQUIRE( event["ph"] == "X" );
+          if(event["name"] == "test::outer"){
+            outer = event;
+          }else if(event["name"] == "test::inner"){
+            inner = event;
+          }else if(event["name"] == "test::thread"){
+            thread = event;
+          }
+        }
+
+        REQUIRE( outer["args"]["detail"] == "some detail" );
+        REQUIRE_FALSE( inner.contains("args") );
+        REQUIRE( outer["tid"] == inner["tid"] );
+        REQUIRE( outer["tid"] != thread["tid"] );
+
+        // the inner span lies within the outer one
+        REQUIRE( inner["ts"].get<double>() >= outer["ts"].get<double>() );
+        REQUIRE( inner["ts"].get<double>() + inner["dur"].get<double>()
+                 <= outer["ts"].get<double>() + outer["dur"].get<double>() );
+
+      } // THEN
+
+    } // WHEN
+
+    Trace::stop();
+
+  } // GIVEN
+
+  GIVEN( "tracing started with room for four spans per thread" ) {
+
+    Trace::start(4);
+
+    WHEN( "ten spans end on one thread" ) {
+
+      for(int i = 0; i < 10; i++){
+        Trace::Span span("test::ring", std::to_string(i));
+      }
+      Trace::stop();
+
+      THEN( "only the newest four are kept, oldest first" ) {
+
+        REQUIRE( Trace::size() == 4 );
+        REQUIRE( Trace::dropped() == 6 );
+
+        auto output = writeTrace();
+        REQUIRE( output["otherData"]["dropped_spans"] == 6 );
+
+        std::string details;
+        for(const auto& event : output["traceEvents"]){
+          if(event["ph"] == "X"){
+            details += event["args"]["detail"].get<std::string>();
+          }
+        }
+        REQUIRE( details == "6789" );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a span has a long detail" ) {
+
+      { Trace::Span span("test::long", std::string(200, 'x')); }
+      Trace::stop();
+
+      THEN( "it is cut short" ) {
+
+        auto output = writeTrace();
+        for(const auto& event : output["traceEvents"]){
+          if(event["ph"] == "X"){
+            auto detail = event["args"]["detail"].get<std::string>();
+            REQUIRE( detail.size() < 200 );
+            REQUIRE( detail == std::string(detail.size(), 'x') );
+          }
+        }
+
+      } // THEN
+
+    } // WHEN
+
+    Trace::stop();
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "BETHYW_TRACE_SCOPE only records spans in a tracing build",
+          "[Trace]" ) {
+
+  GIVEN( "tracing that has been started" ) {
+
+    Trace::start();
+
+    WHEN( "a traced scope ends" ) {
+
+      {
+        BETHYW_TRACE_SCOPE("test::scope");
+        BETHYW_TRACE_SCOPE("test::scope", "with detail");
+      }
+      Trace::stop();
+
+      THEN( "it is recorded if tracing is compiled in, and not otherwise" ) {
+
+        REQUIRE( Trace::size() == (Trace::COMPILED_IN ? 2 : 0) );
+
+      } // THEN
+
+    } // WHEN
+
+    Trace::stop();
+
+  } // GIVEN
+
+} // SCENARIO
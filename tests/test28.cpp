@@ -0,0 +1,458 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+#ifndef _WIN32
+#include <csignal>
+#include <future>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include "../areas.h"
+#include "../bethyw.h"
+#include "../datasets.h"
+#include "../filter.h"
+#include "../runstats.h"
+#include "../server.h"
+
+namespace {
+
+const std::string DIR = "../datasets/";
+
+// Load every dataset into its own Areas in a QueryServer, as --serve does
+void loadServer(QueryServer& server) {
+  for(const auto& source : BethYw::InputFiles::DATASETS){
+    Areas data(Areas::Arena);
+    REQUIRE( BethYw::loadDatasets(data, DIR, {source}, FilterSpec()) );
+    server.addDataset(source, std::move(data));
+  }
+}
+
+// The output bethyw prints for some datasets and filters, imported directly
+std::string importAndPrint(const std::vector<BethYw::InputFileSource>& sources,
+                           const StringFilterSet& areasFilter,
+                           const StringFilterSet& measuresFilter,
+                           const YearFilterTuple& yearsFilter,
+                           bool json) {
+  const FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+  Areas data(Areas::Arena);
+  BethYw::loadAreas(data, DIR, filter);
+  REQUIRE( BethYw::loadDatasets(data, DIR, sources, filter) );
+
+  std::ostringstream output;
+  if(json){
+    data.writeJSON(output);
+    output << std::endl;
+  }else{
+    output << data << std::endl;
+  }
+  return output.str();
+}
+
+std::vector<BethYw::InputFileSource> allDatasets() {
+  return std::vector<BethYw::InputFileSource>(
+      std::begin(BethYw::InputFiles::DATASETS),
+      std::end(BethYw::InputFiles::DATASETS));
+}
+
+std::vector<BethYw::InputFileSource> datasetsWithCodes(
+    const std::unordered_set<std::string>& codes) {
+  std::vector<BethYw::InputFileSource> sources;
+  for(const auto& source : BethYw::InputFiles::DATASETS){
+    if(codes.count(source.CODE)){
+      sources.push_back(source);
+    }
+  }
+  return sources;
+}
+
+} // namespace
+
+SCENARIO( "selecting from an Areas instance filters it as populate() does",
+          "[Areas][select]" ) {
+
+  GIVEN( "the popden dataset imported without filters" ) {
+
+    const auto sources = datasetsWithCodes({"popden"});
+    Areas all(Areas::Arena);
+    REQUIRE( BethYw::loadDatasets(all, DIR, sources, FilterSpec()) );
+
+    WHEN( "a selection is made with filters" ) {
+
+      const StringFilterSet areasFilter = {"W06000011", "W06000023"};
+      const StringFilterSet measuresFilter = {"pop"};
+      const YearFilterTuple yearsFilter(2010, 2012);
+      const FilterSpec filter(&areasFilter, &measuresFilter, &yearsFilter);
+
+      Areas selected = all.select(filter);
+
+      THEN( "it is the same as importing with the filters" ) {
+
+        Areas filtered(Areas::Arena);
+        REQUIRE( BethYw::loadDatasets(filtered, DIR, sources, filter) );
+        REQUIRE( selected.getAreasView() == filtered.getAreasView() );
+        REQUIRE( selected.size() == 2 );
+        REQUIRE( selected.getArea("W06000011").size() == 1 );
+        REQUIRE( selected.getArea("W06000011").getMeasure("pop").size() == 3 );
+
+      } // THEN
+
+      THEN( "the original is unchanged" ) {
+
+        REQUIRE( all.size() > 2 );
+        REQUIRE( all.getArea("W06000011").size() > 1 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "a selection is made that no value passes" ) {
+
+      const StringFilterSet noAreas;
+      const StringFilterSet measuresFilter = {"nothing"};
+      const YearFilterTuple yearsFilter(0, 0);
+      Areas selected = all.select(FilterSpec(&noAreas, &measuresFilter,
+                                             &yearsFilter));
+
+      THEN( "no Areas are selected" ) {
+
+        REQUIRE( selected.size() == 0 );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "the areas file imported without filters" ) {
+
+    Areas names(Areas::Arena);
+    BethYw::loadAreas(names, DIR, FilterSpec());
+
+    WHEN( "a selection is made with an area filter" ) {
+
+      const StringFilterSet areasFilter = {"W06000011"};
+      Areas selected = names.select(FilterSpec(&areasFilter, nullptr, nullptr));
+
+      THEN( "the named Area is selected, though it has no values" ) {
+
+        REQUIRE( selected.size() == 1 );
+        REQUIRE( selected.getArea("W06000011").getName("eng") == "Swansea" );
+        REQUIRE( selected.getArea("W06000011").getName("cym") == "Abertawe" );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a QueryServer answers queries as bethyw would", "[QueryServer]" ) {
+
+  GIVEN( "a QueryServer with every dataset loaded" ) {
+
+    Areas names(Areas::Arena);
+    BethYw::loadAreas(names, DIR, FilterSpec());
+    QueryServer server(std::move(names));
+    loadServer(server);
+
+    WHEN( "it is queried for everything" ) {
+
+      THEN( "the tables and the JSON are the same as importing everything" ) {
+
+        const StringFilterSet none;
+        const YearFilterTuple allYears(0, 0);
+        REQUIRE( server.query("--datasets all")
+                 == importAndPrint(allDatasets(), none, none, allYears, false) );
+        REQUIRE( server.query("--json")
+                 == importAndPrint(allDatasets(), none, none, allYears, true) );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "it is queried with filters" ) {
+
+      THEN( "the output is the same as importing with the filters" ) {
+
+        const StringFilterSet areasFilter = {"W06000011", "W06000023"};
+        const StringFilterSet measuresFilter = {"pop", "dens"};
+        const YearFilterTuple yearsFilter(2010, 2015);
+        REQUIRE( server.query("-d popden,trains -a W06000011,W06000023 "
+                              "-m pop,dens -y 2010-2015 --json")
+                 == importAndPrint(datasetsWithCodes({"popden", "trains"}),
+                                   areasFilter, measuresFilter, yearsFilter,
+                                   true) );
+
+        const StringFilterSet none;
+        const YearFilterTuple year(2015, 2015);
+        REQUIRE( server.query("  --datasets biz\t--years 2015  ")
+                 == importAndPrint(datasetsWithCodes({"biz"}), none, none,
+                                   year, false) );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "it is sent queries through respond()" ) {
+
+      THEN( "answers are prefixed with their length" ) {
+
+        const std::string output = server.query("-a W06000011");
+        REQUIRE( server.respond("-a W06000011")
+                 == "OK " + std::to_string(output.size()) + "\n" + output );
+
+      } // THEN
+
+      THEN( "invalid queries are answered with the error" ) {
+
+        REQUIRE( server.respond("--years 20")
+                 == "ERROR Invalid input for years argument\n" );
+        REQUIRE( server.respond("--datasets nope")
+                 == "ERROR No dataset matches key: nope\n" );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+  GIVEN( "a QueryServer with only some datasets loaded" ) {
+
+    Areas names(Areas::Arena);
+    BethYw::loadAreas(names, DIR, FilterSpec());
+    QueryServer server(std::move(names));
+    for(const auto& source : datasetsWithCodes({"trains"})){
+      Areas data(Areas::Arena);
+      REQUIRE( BethYw::loadDatasets(data, DIR, {source}, FilterSpec()) );
+      server.addDataset(source, std::move(data));
+    }
+
+    WHEN( "a dataset that was not loaded is queried" ) {
+
+      THEN( "an exception is thrown" ) {
+
+        REQUIRE_THROWS_AS( server.query("-d popden"), std::invalid_argument );
+        REQUIRE_THROWS_WITH( server.query("-d popden,trains"),
+                             "Dataset not loaded: popden" );
+        REQUIRE_NOTHROW( server.query("-d trains") );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "it is queried for everything" ) {
+
+      THEN( "the output is for every dataset it loaded" ) {
+
+        const StringFilterSet none;
+        const StringFilterSet areasFilter = {"W06000011"};
+        const YearFilterTuple allYears(0, 0);
+        const YearFilterTuple year(2010, 2010);
+        REQUIRE( server.query("--datasets all -a W06000011 -y 2010")
+                 == importAndPrint(datasetsWithCodes({"trains"}), areasFilter,
+                                   none, year, false) );
+        REQUIRE( server.query("")
+                 == importAndPrint(datasetsWithCodes({"trains"}), none, none,
+                                   allYears, false) );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+#ifndef _WIN32
+
+namespace {
+
+int connectTo(const std::string& socketPath) {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  socketPath.copy(address.sun_path, sizeof(address.sun_path) - 1);
+  for(int attempt = 0; attempt < 100; attempt++){
+    const int client = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if(::connect(client, reinterpret_cast<const sockaddr*>(&address),
+                 sizeof(address)) == 0){
+      return client;
+    }
+    ::close(client);
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+  return -1;
+}
+
+// Read until the peer closes the connection, or expected bytes are read
+std::string receive(int client, std::size_t expected) {
+  std::string received;
+  char chunk[4096];
+  while(received.size() < expected){
+    const ssize_t count = ::recv(client, chunk, sizeof(chunk), 0);
+    if(count <= 0){
+      break;
+    }
+    received.append(chunk, static_cast<std::size_t>(count));
+  }
+  return received;
+}
+
+} // namespace
+
+SCENARIO( "a QueryServer answers clients on a Unix domain socket",
+          "[QueryServer][socket]" ) {
+
+  GIVEN( "a QueryServer serving on a socket" ) {
+
+    Areas names(Areas::Arena);
+    BethYw::loadAreas(names, DIR, FilterSpec());
+    QueryServer server(std::move(names));
+    for(const auto& source : datasetsWithCodes({"popden", "trains"})){
+      Areas data(Areas::Arena);
+      REQUIRE( BethYw::loadDatasets(data, DIR, {source}, FilterSpec()) );
+      server.addDataset(source, std::move(data));
+    }
+
+    const std::string socketPath =
+        "bethyw-test-" + std::to_string(::getpid()) + ".sock";
+    std::thread serving([&server, &socketPath]() {
+      server.serve(socketPath, 2);
+    });
+
+    WHEN( "two clients send queries at once" ) {
+
+      const std::string swansea = server.respond("-d popden -a W06000011");
+      const std::string trains = server.respond("-d trains -j");
+
+      const int first = connectTo(socketPath);
+      const int second = connectTo(socketPath);
+      REQUIRE( first >= 0 );
+      REQUIRE( second >= 0 );
+
+      const std::string firstQueries =
+          "-d popden -a W06000011\n\n-d trains -j\nquit\n";
+      const std::string secondQueries = "-d trains -j\r\n--years x\n";
+      REQUIRE( ::send(first, firstQueries.data(), firstQueries.size(), 0)
+               == static_cast<ssize_t>(firstQueries.size()) );
+      REQUIRE( ::send(second, secondQueries.data(), secondQueries.size(), 0)
+               == static_cast<ssize_t>(secondQueries.size()) );
+
+      const std::string error = "ERROR Invalid input for years argument\n";
+      const std::string firstReplies = receive(first, std::string::npos);
+      const std::string secondReplies =
+          receive(second, trains.size() + error.size());
+      ::close(first);
+      ::close(second);
+
+      server.stop();
+      serving.join();
+
+      THEN( "each is answered in turn, and quit closes the connection" ) {
+
+        REQUIRE( firstReplies == swansea + trains );
+        REQUIRE( secondReplies == trains + error );
+
+      } // THEN
+
+      THEN( "the socket is removed when the server stops" ) {
+
+        REQUIRE( ::access(socketPath.c_str(), F_OK) != 0 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "it is stopped with a client still connected" ) {
+
+      const int client = connectTo(socketPath);
+      REQUIRE( client >= 0 );
+
+      server.stop();
+      serving.join();
+      const std::string received = receive(client, std::string::npos);
+      ::close(client);
+
+      THEN( "the client's connection is closed" ) {
+
+        REQUIRE( received.empty() );
+
+      } // THEN
+
+    } // WHEN
+
+    if(serving.joinable()){
+      server.stop();
+      serving.join();
+    }
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "bethyw's server stops on SIGTERM", "[QueryServer][serve][signal]" ) {
+
+  GIVEN( "BethYw::serve() serving a dataset on a socket" ) {
+
+    const std::string socketPath =
+        "bethyw-test-signal-" + std::to_string(::getpid()) + ".sock";
+    RunStats stats;
+    auto serving = std::async(std::launch::async, [&socketPath, &stats]() {
+      return BethYw::serve(socketPath, DIR, datasetsWithCodes({"trains"}),
+                           FilterSpec(), 1, 1, &stats);
+    });
+
+    // the handlers are installed before the socket is listened on
+    const int client = connectTo(socketPath);
+    REQUIRE( client >= 0 );
+    ::close(client);
+
+    WHEN( "the process is sent SIGTERM" ) {
+
+      REQUIRE( ::raise(SIGTERM) == 0 );
+      const int exitCode = serving.get();
+
+      THEN( "serve() returns normally and the socket is removed" ) {
+
+        REQUIRE( exitCode == 0 );
+        REQUIRE( ::access(socketPath.c_str(), F_OK) != 0 );
+
+      } // THEN
+
+      THEN( "the loading and serving phases are recorded" ) {
+
+        const auto phases = stats.getPhases();
+        REQUIRE_FALSE( phases.empty() );
+        REQUIRE( phases.back().name == "serve" );
+
+      } // THEN
+
+    } // WHEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+#endif
@@ -0,0 +1,121 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "../input.h"
+
+SCENARIO( "a source file can be memory-mapped and read",
+          "[MappedInputFile][existent]" ) {
+
+  const std::string test_file = "../datasets/areas.csv";
+
+  GIVEN( "a constructed MappedInputFile instance" ) {
+
+    MappedInputFile input(test_file);
+
+    THEN( "the source value can be retrieved" ) {
+
+      REQUIRE( input.getSource() == test_file );
+
+    } // THEN
+
+    THEN( "the view holds the same bytes as the file" ) {
+
+      std::ifstream stream(test_file, std::ios::binary);
+      std::ostringstream contents;
+      contents << stream.rdbuf();
+
+      std::string_view data;
+      REQUIRE_NOTHROW( data = input.open() );
+      REQUIRE( std::string(data) == contents.str() );
+
+      AND_THEN( "opening it again returns the same view" ) {
+
+        REQUIRE( input.open().data() == data.data() );
+        REQUIRE( input.open().size() == data.size() );
+
+      } // AND_THEN
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "an empty source file is memory-mapped as an empty view",
+          "[MappedInputFile][empty]" ) {
+
+  GIVEN( "an empty file" ) {
+
+    const std::string test_file = "test29-empty.txt";
+    { std::ofstream create(test_file, std::ios::trunc); }
+
+    THEN( "opening it returns an empty view without exception" ) {
+
+      MappedInputFile input(test_file);
+      REQUIRE_NOTHROW( input.open() );
+      REQUIRE( input.open().empty() );
+
+    } // THEN
+
+    std::remove(test_file.c_str());
+
+  } // GIVEN
+
+} // SCENARIO
+
+SCENARIO( "a nonexistant source file or a directory cannot be memory-mapped",
+          "[MappedInputFile][nonexistent]" ) {
+
+  GIVEN( "a path to a file that does not exist" ) {
+
+    const std::string test_file = "datasets/jibberish.json";
+    REQUIRE_FALSE( std::ifstream(test_file).is_open() );
+
+    MappedInputFile input(test_file);
+    const std::string exceptionMessage =
+        "InputFile::open: Failed to open file " + test_file;
+
+    THEN( "a std::runtime_error is thrown with message " + exceptionMessage ) {
+
+      REQUIRE_THROWS_AS( input.open(), std::runtime_error );
+      REQUIRE_THROWS_WITH( input.open(), exceptionMessage );
+
+    } // THEN
+
+  } // GIVEN
+
+  GIVEN( "a path to a directory" ) {
+
+    const std::string test_dir = "../datasets";
+    MappedInputFile input(test_dir);
+    const std::string exceptionMessage =
+        "InputFile::open: Failed to open file " + test_dir;
+
+    THEN( "a std::runtime_error is thrown with message " + exceptionMessage ) {
+
+      REQUIRE_THROWS_AS( input.open(), std::runtime_error );
+      REQUIRE_THROWS_WITH( input.open(), exceptionMessage );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
@@ -0,0 +1,105 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  Catch2 test script — https://github.com/catchorg/Catch2
+  Catch2 is licensed under the BOOST license.
+ */
+
+#include "../lib_catch.hpp"
+
+#include <climits>
+#include <stdexcept>
+
+#include "../measure.h"
+
+SCENARIO( "a Measure only holds years within MAX_YEAR_SPAN of each other", "[Measure][span]" ) {
+
+  GIVEN( "a Measure with values for 2000 and 2010" ) {
+
+    Measure measure("pop", "Population");
+    measure.setValue(2000, 1);
+    measure.setValue(2010, 2);
+
+    WHEN( "the earliest year the span allows is set" ) {
+
+      measure.setValue(2010 - Measure::MAX_YEAR_SPAN + 1, 3);
+
+      THEN( "it is stored" ) {
+
+        REQUIRE( measure.size() == 3 );
+        REQUIRE( measure.getValue(2010 - Measure::MAX_YEAR_SPAN + 1) == 3 );
+
+      } // THEN
+
+    } // WHEN
+
+    WHEN( "the latest year the span allows is set" ) {
+
+      measure.setValue(2000 + Measure::MAX_YEAR_SPAN - 1, 4);
+
+      THEN( "it is stored" ) {
+
+        REQUIRE( measure.size() == 3 );
+        REQUIRE( measure.getValue(2000 + Measure::MAX_YEAR_SPAN - 1) == 4 );
+
+      } // THEN
+
+    } // WHEN
+
+    THEN( "a year too far after the first year throws a std::out_of_range" ) {
+
+      const int year = 2000 + Measure::MAX_YEAR_SPAN;
+      REQUIRE_THROWS_AS( measure.setValue(year, 3), std::out_of_range );
+      REQUIRE_THROWS_WITH( measure.setValue(year, 3),
+                           "Year " + std::to_string(year) +
+                           " is too far from the other years of pop" );
+
+      AND_THEN( "the Measure is unchanged" ) {
+
+        REQUIRE( measure.size() == 2 );
+        REQUIRE( measure.getFirstYear() == 2000 );
+        REQUIRE( measure.getLastYear() == 2010 );
+        REQUIRE( measure.getSum() == 3 );
+
+      } // AND_THEN
+
+    } // THEN
+
+    THEN( "a year too far before the last year throws a std::out_of_range" ) {
+
+      REQUIRE_THROWS_AS( measure.setValue(2010 - Measure::MAX_YEAR_SPAN, 3),
+                         std::out_of_range );
+      REQUIRE( measure.getFirstYear() == 2000 );
+
+    } // THEN
+
+    THEN( "years at the limits of int throw without overflowing" ) {
+
+      REQUIRE_THROWS_AS( measure.setValue(INT_MAX, 3), std::out_of_range );
+      REQUIRE_THROWS_AS( measure.setValue(INT_MIN, 3), std::out_of_range );
+      REQUIRE_THROWS_AS( measure.getValue(INT_MAX), std::out_of_range );
+      REQUIRE_THROWS_AS( measure.getValue(INT_MIN), std::out_of_range );
+      REQUIRE( measure.size() == 2 );
+
+    } // THEN
+
+    THEN( "accumulating a Measure that would be too wide throws a std::out_of_range" ) {
+
+      Measure other("pop", "Population");
+      other.setValue(2000 + Measure::MAX_YEAR_SPAN, 5);
+      REQUIRE_THROWS_AS( measure.accumulate(other), std::out_of_range );
+      REQUIRE( measure.getFirstYear() == 2000 );
+      REQUIRE( measure.getLastYear() == 2010 );
+
+    } // THEN
+
+  } // GIVEN
+
+} // SCENARIO
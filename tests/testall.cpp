@@ -24,3 +24,20 @@
 #include "test10.cpp"
 #include "test11.cpp"
 #include "test12.cpp"
+#include "test13.cpp"
+#include "test14.cpp"
+#include "test15.cpp"
+#include "test16.cpp"
+#include "test17.cpp"
+#include "test18.cpp"
+#include "test19.cpp"
+#include "test21.cpp"
+#include "test22.cpp"
+#include "test23.cpp"
+#include "test24.cpp"
+#include "test25.cpp"
+#include "test26.cpp"
+#include "test27.cpp"
+#include "test28.cpp"
+#include "test29.cpp"
+#include "test30.cpp"
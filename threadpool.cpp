@@ -0,0 +1,82 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the ThreadPool class. See the
+  header file for additional comments.
+*/
+
+#include "threadpool.h"
+#include "trace.h"
+
+/*
+  ThreadPool::ThreadPool(threads)
+
+  Start a pool of worker threads.
+
+  @param threads
+    The number of worker threads to start, which is at least one
+
+  @example
+    ThreadPool pool(std::thread::hardware_concurrency());
+*/
+ThreadPool::ThreadPool(unsigned int threads) {
+  if(threads == 0){
+    threads = 1;
+  }
+  workers.reserve(threads);
+  for(unsigned int i = 0; i < threads; i++){
+    workers.emplace_back(&ThreadPool::work, this);
+  }
+}
+
+/*
+  ThreadPool::~ThreadPool()
+
+  Let the workers finish every task already submitted, then join them.
+*/
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(tasksMutex);
+    stopping = true;
+  }
+  tasksAvailable.notify_all();
+  for(auto& worker : workers){
+    worker.join();
+  }
+}
+
+/*
+  ThreadPool::size()
+
+  @return
+    The number of worker threads in the pool
+*/
+unsigned int ThreadPool::size() const noexcept{
+  return workers.size();
+}
+
+// The loop run by each worker thread: take the oldest task off the queue and
+// run it, until the pool is stopping and the queue is empty.
+void ThreadPool::work(){
+  while(true){
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(tasksMutex);
+      tasksAvailable.wait(lock, [this]() { return stopping || !tasks.empty(); });
+      if(tasks.empty()){
+        return;
+      }
+      task = std::move(tasks.front());
+      tasks.pop_front();
+    }
+    BETHYW_TRACE_SCOPE("ThreadPool::task");
+    task();
+  }
+}
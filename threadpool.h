@@ -0,0 +1,83 @@
+#ifndef THREADPOOL_H_
+#define THREADPOOL_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the ThreadPool class, a fixed set of worker threads that
+  run tasks submitted to a shared queue.
+ */
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+  A ThreadPool starts a fixed number of worker threads when it is constructed.
+  Tasks passed to submit() are run by the first free worker, in the order they
+  were submitted, and their result (or exception) is handed back through a
+  std::future.
+
+  Destroying the pool waits for every task that has already been submitted
+  to finish before joining the workers.
+
+  Tasks must not block waiting on the future of another task in the same
+  pool, as every worker could end up waiting.
+*/
+class ThreadPool {
+  private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex tasksMutex;
+    std::condition_variable tasksAvailable;
+    bool stopping = false;
+
+    void work();
+public:
+  ThreadPool(unsigned int threads);
+  ThreadPool(const ThreadPool& other) = delete;
+  ThreadPool& operator=(const ThreadPool& other) = delete;
+  ~ThreadPool();
+  unsigned int size() const noexcept;
+
+  /*
+    Queue a callable to be run on one of the worker threads.
+
+    @param task
+      A callable taking no arguments
+
+    @return
+      A std::future for the value returned by task. If task throws, the
+      exception is rethrown by std::future::get().
+
+    @example
+      ThreadPool pool(4);
+      auto result = pool.submit([]() { return 6 * 7; });
+      int answer = result.get();
+  */
+  template <typename Task>
+  std::future<std::invoke_result_t<Task>> submit(Task task) {
+    using Result = std::invoke_result_t<Task>;
+    // std::function must be copyable, so the packaged_task lives on the heap
+    auto packaged = std::make_shared<std::packaged_task<Result()>>(std::move(task));
+    std::future<Result> result = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(tasksMutex);
+      tasks.emplace_back([packaged]() { (*packaged)(); });
+    }
+    tasksAvailable.notify_one();
+    return result;
+  }
+};
+
+#endif // THREADPOOL_H_
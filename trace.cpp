@@ -0,0 +1,244 @@
+
+
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the implementation of the Trace namespace. See the
+  header file for additional comments.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "lib_json.hpp"
+
+#include "trace.h"
+
+using json = nlohmann::json;
+
+namespace {
+
+// A recorded span. Times are steady_clock nanoseconds
+struct Event {
+  const char* name = nullptr;
+  char detail[Trace::MAX_DETAIL_LENGTH + 1] = {};
+  std::int64_t start = 0;
+  std::int64_t duration = 0;
+};
+
+// A ring buffer of the spans recorded on one thread. recorded counts every
+// span since start(), so the buffer has wrapped once it exceeds the size
+struct ThreadBuffer {
+  std::vector<Event> events;
+  std::uint64_t recorded = 0;
+  unsigned int id = 0;
+};
+
+/*
+  Every thread's buffer, kept here rather than by the thread so that spans
+  recorded on a ThreadPool worker outlive it. A thread only takes the lock
+  once, to add its buffer.
+*/
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+  std::size_t spansPerThread = Trace::DEFAULT_SPANS_PER_THREAD;
+  std::int64_t origin = 0;
+  std::atomic<bool> recording{false};
+};
+
+Registry& registry() {
+  static Registry traces;
+  return traces;
+}
+
+thread_local ThreadBuffer* threadBuffer = nullptr;
+
+std::int64_t now() noexcept {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ThreadBuffer& getThreadBuffer() {
+  if(threadBuffer == nullptr){
+    Registry& traces = registry();
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    auto buffer = std::make_unique<ThreadBuffer>();
+    buffer->events.resize(std::max<std::size_t>(1, traces.spansPerThread));
+    buffer->id = static_cast<unsigned int>(traces.buffers.size());
+    traces.buffers.push_back(std::move(buffer));
+    threadBuffer = traces.buffers.back().get();
+  }
+  return *threadBuffer;
+}
+
+// Chrome trace timestamps are in microseconds
+double toMicroseconds(std::int64_t nanoseconds) {
+  return nanoseconds / 1000.0;
+}
+
+} // namespace
+
+/*
+  Trace::Span::Span(name, detail)
+
+  Start a span, if spans are being recorded.
+
+  @param name
+    The name of the span, which must outlive the trace
+
+  @param detail
+    Text shown as the detail argument of the span, or empty for none
+
+  @example
+    Trace::Span span("MappedInputFile::open", getSource());
+*/
+Trace::Span::Span(const char* name, std::string_view detail) noexcept
+    : name(name),
+      start(registry().recording.load(std::memory_order_relaxed) ? now() : -1) {
+  if(start < 0){
+    return;
+  }
+  const std::size_t length = std::min(detail.size(), MAX_DETAIL_LENGTH);
+  std::memcpy(this->detail, detail.data(), length);
+  this->detail[length] = '\0';
+}
+
+/*
+  Trace::Span::~Span()
+
+  End the span and add it to this thread's ring buffer.
+*/
+Trace::Span::~Span() {
+  if(start < 0){
+    return;
+  }
+  const std::int64_t end = now();
+  try{
+    ThreadBuffer& buffer = getThreadBuffer();
+    Event& event = buffer.events[buffer.recorded % buffer.events.size()];
+    event.name = name;
+    event.start = start;
+    event.duration = end - start;
+    std::memcpy(event.detail, detail, sizeof(event.detail));
+    buffer.recorded++;
+  } catch(const std::exception&){
+    // without a buffer the span is lost, but what it traced is not
+  }
+}
+
+/*
+  Trace::start(spansPerThread)
+
+  @example
+    Trace::start();
+    ...
+    Trace::stop();
+    Trace::writeChromeJSON(file);
+*/
+void Trace::start(std::size_t spansPerThread) {
+  Registry& traces = registry();
+  std::lock_guard<std::mutex> lock(traces.mutex);
+  traces.spansPerThread = std::max<std::size_t>(1, spansPerThread);
+  for(auto& buffer : traces.buffers){
+    buffer->events.assign(traces.spansPerThread, Event());
+    buffer->recorded = 0;
+  }
+  traces.origin = now();
+  traces.recording.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop() noexcept {
+  registry().recording.store(false, std::memory_order_relaxed);
+}
+
+bool Trace::isRecording() noexcept {
+  return registry().recording.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Trace::dropped() {
+  Registry& traces = registry();
+  std::lock_guard<std::mutex> lock(traces.mutex);
+  std::uint64_t count = 0;
+  for(const auto& buffer : traces.buffers){
+    if(buffer->recorded > buffer->events.size()){
+      count += buffer->recorded - buffer->events.size();
+    }
+  }
+  return count;
+}
+
+std::size_t Trace::size() {
+  Registry& traces = registry();
+  std::lock_guard<std::mutex> lock(traces.mutex);
+  std::size_t count = 0;
+  for(const auto& buffer : traces.buffers){
+    count += std::min<std::uint64_t>(buffer->recorded, buffer->events.size());
+  }
+  return count;
+}
+
+/*
+  Trace::writeChromeJSON(os)
+
+  @example
+    std::ofstream file("bethyw.trace.json");
+    Trace::writeChromeJSON(file);
+    // {"displayTimeUnit":"ms","otherData":{"dropped_spans":0},
+    //  "traceEvents":[{"name":"thread_name","ph":"M",...},
+    //                 {"name":"Areas::merge","ph":"X","ts":1520.3,...},...]}
+*/
+void Trace::writeChromeJSON(std::ostream& os) {
+  const std::uint64_t droppedSpans = dropped();
+
+  Registry& traces = registry();
+  std::lock_guard<std::mutex> lock(traces.mutex);
+  json events = json::array();
+  for(const auto& buffer : traces.buffers){
+    if(buffer->recorded == 0){
+      continue;
+    }
+    events.push_back({{"name", "thread_name"},
+                      {"ph", "M"},
+                      {"pid", 1},
+                      {"tid", buffer->id},
+                      {"args", {{"name",
+                                 "thread " + std::to_string(buffer->id)}}}});
+
+    // oldest first, starting after the newest once the buffer has wrapped
+    const std::size_t capacity = buffer->events.size();
+    const std::size_t kept = std::min<std::uint64_t>(buffer->recorded, capacity);
+    const std::size_t first = buffer->recorded > capacity
+                              ? buffer->recorded % capacity : 0;
+    for(std::size_t i = 0; i < kept; i++){
+      const Event& event = buffer->events[(first + i) % capacity];
+      json span{{"name", event.name},
+                {"cat", "bethyw"},
+                {"ph", "X"},
+                {"ts", toMicroseconds(event.start - traces.origin)},
+                {"dur", toMicroseconds(event.duration)},
+                {"pid", 1},
+                {"tid", buffer->id}};
+      if(event.detail[0] != '\0'){
+        span["args"] = {{"detail", event.detail}};
+      }
+      events.push_back(std::move(span));
+    }
+  }
+
+  json output{{"traceEvents", std::move(events)},
+              {"displayTimeUnit", "ms"},
+              {"otherData", {{"dropped_spans", droppedSpans}}}};
+  // a detail cut short in the middle of a character is replaced rather
+  // than making the output invalid
+  os << output.dump(-1, ' ', false, json::error_handler_t::replace) << '\n';
+}
@@ -0,0 +1,145 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+/*
+  +---------------------------------------+
+  | BETH YW? WELSH GOVERNMENT DATA PARSER |
+  +---------------------------------------+
+
+  AUTHOR: 958804
+
+  This file contains the Trace namespace, which records spans of time spent
+  in the main steps of Beth Yw? (opening files, populating, merging and
+  rendering) on every thread, for the --trace argument, and writes them out
+  in the Chrome trace event format.
+
+  Tracing is only compiled in when BETHYW_TRACE is defined, e.g.:
+
+    CXXFLAGS=-DBETHYW_TRACE ./build.sh
+
+  Otherwise BETHYW_TRACE_SCOPE() expands to nothing, and traced code is the
+  same as if it were not traced.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+#ifdef BETHYW_TRACE
+#define BETHYW_TRACE_CONCAT_(a, b) a##b
+#define BETHYW_TRACE_CONCAT(a, b) BETHYW_TRACE_CONCAT_(a, b)
+
+/*
+  Trace the rest of the enclosing scope as a span with the given name (a
+  string literal), and optionally a detail (any text, e.g. a filename), which
+  is shown as an argument of the span.
+
+  @example
+    void Areas::merge(Areas&& other){
+      BETHYW_TRACE_SCOPE("Areas::merge");
+      ...
+    }
+*/
+#define BETHYW_TRACE_SCOPE(...) \
+  Trace::Span BETHYW_TRACE_CONCAT(traceSpan, __LINE__)(__VA_ARGS__)
+#else
+#define BETHYW_TRACE_SCOPE(...) static_cast<void>(0)
+#endif
+
+namespace Trace {
+
+/*
+  True if BETHYW_TRACE_SCOPE() records spans in this build.
+*/
+constexpr bool COMPILED_IN =
+#ifdef BETHYW_TRACE
+    true;
+#else
+    false;
+#endif
+
+/*
+  The number of spans each thread keeps by default. Once a thread's ring
+  buffer is full, each new span overwrites its oldest one.
+*/
+constexpr std::size_t DEFAULT_SPANS_PER_THREAD = 1 << 14;
+
+/*
+  The most bytes of a span's detail that are kept.
+*/
+constexpr std::size_t MAX_DETAIL_LENGTH = 47;
+
+/*
+  A span of time on one thread. Spans are recorded from when they are
+  constructed until they are destroyed, and only while tracing is started.
+
+  Each thread records into its own ring buffer, so recording a span takes no
+  locks and makes no allocations, except for the first span on a thread,
+  which allocates that thread's buffer.
+
+  The name must outlive the trace (i.e. be a string literal). The detail is
+  copied when the span starts, and cut short to MAX_DETAIL_LENGTH bytes.
+*/
+class Span {
+  public:
+    explicit Span(const char* name, std::string_view detail = {}) noexcept;
+    Span(const Span& other) = delete;
+    Span& operator=(const Span& other) = delete;
+    ~Span();
+
+  private:
+    const char* name;
+    std::int64_t start;
+    char detail[MAX_DETAIL_LENGTH + 1];
+};
+
+/*
+  Start recording spans, discarding any recorded before.
+
+  @param spansPerThread
+    The size of each thread's ring buffer
+*/
+void start(std::size_t spansPerThread = DEFAULT_SPANS_PER_THREAD);
+
+/*
+  Stop recording spans. The spans recorded so far are kept until the next
+  start().
+*/
+void stop() noexcept;
+
+/*
+  @return
+    True if spans are being recorded
+*/
+bool isRecording() noexcept;
+
+/*
+  @return
+    The number of spans lost because a thread's ring buffer was full
+*/
+std::uint64_t dropped();
+
+/*
+  @return
+    The number of spans currently kept across all threads
+*/
+std::size_t size();
+
+/*
+  Write the spans recorded as a Chrome trace event JSON object, which can be
+  opened with chrome://tracing or https://ui.perfetto.dev. Each span is a
+  complete ("X") event, with timestamps in microseconds since start().
+
+  This must only be called when no other thread is recording spans, e.g.
+  after stop() once the work being traced has finished.
+
+  @param os
+    The stream to write to
+*/
+void writeChromeJSON(std::ostream& os);
+
+} // namespace Trace
+
+#endif // TRACE_H_